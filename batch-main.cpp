@@ -0,0 +1,100 @@
+/* Batch encryption program
+ * 
+ * This file contains the main program for encrypting many message files at
+ * once. Usage:
+ * './batch [-b] [-e <engine>] <output directory> <plugboard> <reflector>
+ *  <rotorI>...<rotorx> <rotor pos>'
+ * The message files are named on standard input, one per line. Each is
+ * encrypted from the start positions into a file of the same name in the
+ * output directory. '-b' uses blocking reads and writes even where io_uring
+ * is available, and '-e' names the encryption engine to use instead of
+ * timing them all. */
+
+#include "errors.h"
+#include "enigma.h"
+#include "batch.h"
+#include "engine.h"
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+using namespace std;
+
+
+int main(int argc, char** argv)
+{
+    bool use_ring = true;
+    int first = 1, forced = -1, err = NO_ERROR;
+
+    for (; first < argc && argv[first][0] == '-'; first++) {
+        string option = argv[first];
+        if (option == "-b")
+            use_ring = false;
+        else if (option == "-e" && first + 1 < argc)
+            forced = engineIndex(argv[++first]);
+
+        if (option != "-b" && forced < 0) {
+            cerr << "Unknown option or engine '" << argv[first] << "'. ";
+            cerr << "Engines are:";
+            for (int i = 0; i < noOfEngines(); i++)
+                cerr << ' ' << engine(i).name;
+            cerr << ".\n";
+            return INSUFFICIENT_NUMBER_OF_PARAMETERS;
+        }
+    }
+
+    if (argc - first < 3) {
+        cerr << "Too few command line parameters given.\n";
+        cerr << "'./batch [-b] [-e <engine>] <output directory> <plugboard> ";
+        cerr << "<reflector> <rotorI>...<rotorx> <rotor pos>'\n\n";
+        return INSUFFICIENT_NUMBER_OF_PARAMETERS;
+    }
+
+    string directory = argv[first];
+    struct stat info;
+    if (stat(directory.c_str(), &info) || !S_ISDIR(info.st_mode)) {
+        cerr << "Error opening '" << directory << "'.\n";
+        return ERROR_OPENING_CONFIGURATION_FILE;
+    }
+
+    Enigma<> base(argc - first - 4);
+    base.setConfig(argc - first, argv + first, err);
+    // The output directory stands in for the program name
+    if (err) {
+        cerr << "Error code " << err << ". Exiting...\n";
+        return err;
+    }
+
+    vector<BatchJob> jobs;
+    string name;
+    while (getline(cin, name)) {
+        if (name.empty())
+            continue;
+        BatchJob job = {name, directory + '/' + name.substr(name.rfind('/') + 1),
+                        NO_ERROR};
+        jobs.push_back(job);
+    }
+
+    auto start = chrono::steady_clock::now();
+    EngineSelector engines(forced);
+    bool ring_used = encryptBatch(base, engines, jobs, use_ring);
+    chrono::duration<double> taken = chrono::steady_clock::now() - start;
+
+    int failed = 0;
+    for (BatchJob const& job : jobs) {
+        if (job.err) {
+            cerr << "Error code " << job.err << " for '" << job.input << "'.\n";
+            if (!failed++)
+                err = job.err;
+        }
+    }
+
+    cerr << jobs.size() - failed << " of " << jobs.size() << " files ";
+    cerr << "encrypted in " << taken.count() << " s, using ";
+    cerr << (ring_used ? "io_uring" : "blocking reads and writes") << ".\n";
+    engines.report(cerr);
+
+    return err;
+}
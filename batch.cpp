@@ -0,0 +1,549 @@
+/* Batch encryption functions
+ *
+ * This file contains the definitions for encrypting a batch of message
+ * files, and a bare io_uring set up with raw system calls.
+ */
+
+#include "errors.h"
+#include "batch.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <thread>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+
+/* What each operation in flight was submitted for. */
+enum Stage { OPEN_INPUT, READ_INPUT, OPEN_OUTPUT, WRITE_OUTPUT, CLOSE_INPUT,
+             CLOSE_OUTPUT };
+
+int const RING_OPCODES[] = {IORING_OP_OPENAT, IORING_OP_READ, IORING_OP_WRITE,
+                            IORING_OP_READ_FIXED, IORING_OP_WRITE_FIXED,
+                            IORING_OP_CLOSE};
+int const DRAIN_POLLS = 5000; // Waits of DRAIN_POLL_NS for a failed ring
+long const DRAIN_POLL_NS = 1000000;
+
+
+/* The 'Ring' class is one io_uring: a submission queue and a completion
+   queue shared with the kernel. It is only used from one thread. */
+class Ring {
+ public:
+    Ring();
+    ~Ring();
+
+    bool setup(unsigned entries);
+    /* Postcondition:
+       If the kernel supports io_uring and every opcode used here, a ring
+       with room for 'entries' submissions is set up and true returned.
+       Otherwise false is returned. */
+
+    bool registerBuffers(iovec const buffers[], unsigned n);
+    /* Postcondition:
+       True is returned if the 'n' buffers are now registered, so may be
+       used by fixed reads and writes, their index being 'buf_index'. */
+
+    io_uring_sqe* next();
+    /* Postcondition:
+       A cleared submission entry is returned, queued to be sent by the next
+       'submit'. If the queue is full, what is queued is sent first. */
+
+    bool submit(unsigned wait);
+    /* Postcondition:
+       Every queued entry is sent to the kernel, at least 'wait' completions
+       are waited for, and true is returned. If the kernel refuses for any
+       reason but an interrupted call, false is returned. */
+
+    bool reap(io_uring_cqe& cqe);
+    /* Postcondition:
+       If a completion is ready, it is copied to 'cqe', removed from the
+       queue and true returned. Otherwise false is returned. */
+
+    void retract(std::vector<io_uring_sqe>& unsent);
+    /* Postcondition:
+       Every queued entry the kernel has not taken is removed from the
+       queue and copied to 'unsent', so it will never be run. */
+
+    void close();
+    /* Postcondition:
+       The ring is unmapped and its file closed, which cancels whatever
+       is still in flight. */
+
+    unsigned completions() const
+    { return cq_entries_; }
+    /* Postcondition:
+       The number of completions the ring holds before they must be
+       reaped is returned. */
+
+ private:
+    int fd_;
+    unsigned entries_;
+    unsigned cq_entries_;
+    unsigned tail_; // Submission tail, ahead of the kernel's by what is queued
+    void* sq_ring_;
+    void* cq_ring_;
+    size_t sq_size_;
+    size_t cq_size_;
+    io_uring_sqe* sqes_;
+    unsigned* sq_tail_;
+    unsigned* sq_head_;
+    unsigned* sq_mask_;
+    unsigned* sq_array_;
+    unsigned* cq_head_;
+    unsigned* cq_tail_;
+    unsigned* cq_mask_;
+    io_uring_cqe* cqes_;
+
+    Ring(Ring const&); // Not copyable
+};
+
+
+Ring::Ring()
+    : fd_(-1), sq_ring_(MAP_FAILED), cq_ring_(MAP_FAILED), sqes_(nullptr)
+{
+}
+
+
+Ring::~Ring()
+{
+    close();
+}
+
+
+void Ring::close()
+{
+    if (sqes_)
+        munmap(sqes_, entries_ * sizeof(io_uring_sqe));
+    if (cq_ring_ != MAP_FAILED && cq_ring_ != sq_ring_)
+        munmap(cq_ring_, cq_size_);
+    if (sq_ring_ != MAP_FAILED)
+        munmap(sq_ring_, sq_size_);
+    if (fd_ >= 0)
+        ::close(fd_);
+
+    fd_ = -1;
+    sq_ring_ = cq_ring_ = MAP_FAILED;
+    sqes_ = nullptr;
+}
+
+
+bool Ring::setup(unsigned entries)
+{
+    io_uring_params params;
+
+    memset(&params, 0, sizeof(params));
+    fd_ = syscall(__NR_io_uring_setup, entries, &params);
+    if (fd_ < 0)
+        return false; // No io_uring, or forbidden here
+
+    vector<char> storage
+        (sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op));
+    io_uring_probe* probe = (io_uring_probe*) storage.data();
+    if (syscall(__NR_io_uring_register, fd_, IORING_REGISTER_PROBE,
+                probe, 256))
+        return false;
+    for (int opcode : RING_OPCODES) {
+        if (opcode > probe->last_op ||
+            !(probe->ops[opcode].flags & IO_URING_OP_SUPPORTED))
+            return false;
+    }
+
+    entries_ = params.sq_entries;
+    cq_entries_ = params.cq_entries;
+    sq_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool single = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single)
+        sq_size_ = cq_size_ = max(sq_size_, cq_size_);
+
+    sq_ring_ = mmap(nullptr, sq_size_, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQ_RING);
+    if (sq_ring_ == MAP_FAILED)
+        return false;
+    cq_ring_ = sq_ring_;
+    if (!single)
+        cq_ring_ = mmap(nullptr, cq_size_, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_CQ_RING);
+    if (cq_ring_ == MAP_FAILED)
+        return false;
+    void* sqes = mmap(nullptr, entries_ * sizeof(io_uring_sqe),
+                      PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      fd_, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED)
+        return false;
+    sqes_ = (io_uring_sqe*) sqes;
+
+    char* sq = (char*) sq_ring_;
+    sq_head_ = (unsigned*) (sq + params.sq_off.head);
+    sq_tail_ = (unsigned*) (sq + params.sq_off.tail);
+    sq_mask_ = (unsigned*) (sq + params.sq_off.ring_mask);
+    sq_array_ = (unsigned*) (sq + params.sq_off.array);
+    char* cq = (char*) cq_ring_;
+    cq_head_ = (unsigned*) (cq + params.cq_off.head);
+    cq_tail_ = (unsigned*) (cq + params.cq_off.tail);
+    cq_mask_ = (unsigned*) (cq + params.cq_off.ring_mask);
+    cqes_ = (io_uring_cqe*) (cq + params.cq_off.cqes);
+    tail_ = *sq_tail_;
+
+    return true;
+}
+
+
+bool Ring::registerBuffers(iovec const buffers[], unsigned n)
+{
+    return !syscall(__NR_io_uring_register, fd_, IORING_REGISTER_BUFFERS,
+                    buffers, n);
+}
+
+
+io_uring_sqe* Ring::next()
+{
+    if (tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) >= entries_)
+        submit(0);
+
+    unsigned index = tail_ & *sq_mask_;
+    sq_array_[index] = index;
+    tail_++;
+
+    memset(&sqes_[index], 0, sizeof(io_uring_sqe));
+    return &sqes_[index];
+}
+
+
+bool Ring::submit(unsigned wait)
+{
+    unsigned queued = tail_ - *sq_tail_;
+
+    __atomic_store_n(sq_tail_, tail_, __ATOMIC_RELEASE);
+    while (syscall(__NR_io_uring_enter, fd_, queued, wait,
+                   wait ? IORING_ENTER_GETEVENTS : 0, nullptr, 0) < 0) {
+        if (errno != EINTR)
+            return false;
+    }
+
+    return true;
+}
+
+
+void Ring::retract(vector<io_uring_sqe>& unsent)
+{
+    unsigned head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+
+    unsent.clear();
+    for (unsigned i = head; i != tail_; i++)
+        unsent.push_back(sqes_[sq_array_[i & *sq_mask_]]);
+    tail_ = head;
+    __atomic_store_n(sq_tail_, tail_, __ATOMIC_RELEASE);
+    // Without a polling thread the kernel only takes entries when entered,
+    // so none can be taken meanwhile
+}
+
+
+bool Ring::reap(io_uring_cqe& cqe)
+{
+    unsigned head = *cq_head_;
+
+    if (head == __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE))
+        return false;
+
+    cqe = cqes_[head & *cq_mask_];
+    __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+
+static long encryptMessage
+(Enigma<> const& base, EngineSelector& engines, char text[], long length,
+ char output[], int& err)
+{
+    Enigma<> machine(base);
+    long n = 0;
+
+    for (long i = 0; i < length && text[i] != '.'; i++) {
+        if (!isspace((unsigned char) text[i]))
+            text[n++] = text[i];
+    } // Read as the main program reads, so the same files give the same text
+
+    engines.encrypt(machine, text, output, n, err);
+    output[n] = '\n';
+
+    return n + 1;
+}
+
+
+static void encryptBlocking
+(Enigma<> const& base, EngineSelector& engines, BatchJob& job)
+{
+    vector<char> text, output;
+    struct stat info;
+    long got = 0, sent = 0, n;
+    int fd = open(job.input.c_str(), O_RDONLY);
+
+    if (fd < 0 || fstat(fd, &info)) {
+        if (fd >= 0)
+            close(fd);
+        job.err = ERROR_OPENING_CONFIGURATION_FILE;
+        return;
+    }
+    text.resize(info.st_size);
+    while (got < long(text.size()) &&
+           (n = read(fd, text.data() + got, text.size() - got)) > 0)
+        got += n;
+    close(fd);
+
+    output.resize(got + 1);
+    long length = encryptMessage
+        (base, engines, text.data(), got, output.data(), job.err);
+    if (job.err)
+        return;
+
+    fd = open(job.output.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    while (fd >= 0 && sent < length &&
+           (n = write(fd, output.data() + sent, length - sent)) > 0)
+        sent += n;
+    if (fd < 0 || close(fd) || sent < length)
+        job.err = ERROR_OPENING_CONFIGURATION_FILE;
+}
+
+
+static void abandonRing(Ring& ring, vector<BatchJob>& jobs, int& in_flight)
+{
+    vector<io_uring_sqe> unsent;
+    io_uring_cqe cqe;
+    timespec poll = {0, DRAIN_POLL_NS};
+
+    ring.retract(unsent);
+    for (io_uring_sqe const& sqe : unsent) {
+        in_flight--;
+        if (sqe.opcode == IORING_OP_CLOSE)
+            close(sqe.fd);
+    } // A queued close is the only owner of its fd
+
+    for (int polls = 0; in_flight > 0 && polls < DRAIN_POLLS; polls++) {
+        while (ring.reap(cqe)) {
+            in_flight--;
+            Stage stage = Stage(cqe.user_data & 0xff);
+            if ((stage == OPEN_INPUT || stage == OPEN_OUTPUT) && cqe.res >= 0)
+                close(cqe.res);
+            if (stage == CLOSE_OUTPUT && cqe.res < 0)
+                jobs[cqe.user_data >> 8].err = ERROR_OPENING_CONFIGURATION_FILE;
+        }
+        if (in_flight > 0)
+            nanosleep(&poll, nullptr);
+    } // Without io_uring_enter, what was sent still completes on its own
+
+    ring.close();
+}
+
+
+static void ringWorker
+(Ring& ring, Enigma<> const& base, EngineSelector& engines,
+ vector<BatchJob>& jobs, atomic<size_t>& next_job)
+{
+    struct Slot {
+        size_t job;
+        int fd; // The input file's while reading, then the output file's
+        long length; // Of the ciphertext
+        bool busy; // Whether 'job' is still being worked on
+    } slots[BATCH_SLOTS];
+    // An open fd belongs to its slot until its close is queued
+    vector<char> buffers(2L * BATCH_SLOTS * BATCH_BUFFER);
+    // Slot i reads into buffer 2i and writes from buffer 2i + 1
+    vector<iovec> iovecs(2 * BATCH_SLOTS);
+    vector<size_t> oversize;
+    int in_flight = 0, closing = 0;
+    int const max_closing = ring.completions() - BATCH_SLOTS;
+    // Every slot has at most one other operation in flight, so this many
+    // closes keep the completion queue from overflowing
+
+    for (int i = 0; i < 2 * BATCH_SLOTS; i++) {
+        iovecs[i].iov_base = buffers.data() + (long) i * BATCH_BUFFER;
+        iovecs[i].iov_len = BATCH_BUFFER;
+    }
+    bool fixed = ring.registerBuffers(iovecs.data(), iovecs.size());
+    // Registering may fail for want of locked memory; plain reads still work
+
+    auto queue = [&](int opcode, int fd, void const* addr, unsigned len,
+                     unsigned long id, Stage stage) {
+        io_uring_sqe* sqe = ring.next();
+        sqe->opcode = opcode;
+        sqe->fd = fd;
+        sqe->addr = (unsigned long) addr;
+        sqe->len = len;
+        sqe->user_data = id << 8 | stage;
+        in_flight++;
+        return sqe;
+    };
+
+    auto closeFile = [&](int slot, Stage stage) {
+        Slot& at = slots[slot];
+        if (closing < max_closing) {
+            queue(IORING_OP_CLOSE, at.fd, nullptr, 0, at.job, stage);
+            closing++;
+        } else if (close(at.fd) && stage == CLOSE_OUTPUT)
+            jobs[at.job].err = ERROR_OPENING_CONFIGURATION_FILE;
+        at.fd = -1;
+    };
+
+    auto start = [&](int slot) {
+        size_t job = next_job++;
+        slots[slot].fd = -1;
+        slots[slot].busy = job < jobs.size();
+        if (job < jobs.size()) {
+            slots[slot].job = job;
+            queue(IORING_OP_OPENAT, AT_FDCWD, jobs[job].input.c_str(), 0,
+                  slot, OPEN_INPUT)->open_flags = O_RDONLY;
+        }
+    };
+
+    for (int slot = 0; slot < BATCH_SLOTS; slot++)
+        start(slot);
+
+    io_uring_cqe cqe;
+    while (in_flight > 0) {
+        if (!ring.submit(1)) {
+            cerr << "io_uring failed, so its files in flight are abandoned ";
+            cerr << "and the rest encrypted with blocking calls.\n";
+            abandonRing(ring, jobs, in_flight);
+            for (Slot const& at : slots) {
+                if (!at.busy)
+                    continue;
+                jobs[at.job].err = ERROR_OPENING_CONFIGURATION_FILE;
+                if (at.fd >= 0)
+                    close(at.fd);
+            }
+            if (in_flight > 0) {
+                cerr << "io_uring did not finish, so its buffers are kept.\n";
+                new vector<char>(move(buffers));
+                // The kernel may yet write to them once cancelled
+            }
+            for (size_t i; (i = next_job++) < jobs.size(); )
+                encryptBlocking(base, engines, jobs[i]);
+            break;
+        }
+
+        while (ring.reap(cqe)) {
+            in_flight--;
+            Stage stage = Stage(cqe.user_data & 0xff);
+            if (stage == CLOSE_OUTPUT && cqe.res < 0)
+                jobs[cqe.user_data >> 8].err = ERROR_OPENING_CONFIGURATION_FILE;
+            if (stage == CLOSE_INPUT || stage == CLOSE_OUTPUT) {
+                closing--;
+                continue; // Tagged with the job, as the slot has moved on
+            }
+
+            int slot = cqe.user_data >> 8;
+            Slot& at = slots[slot];
+            BatchJob& job = jobs[at.job];
+            char* buffer = (char*) iovecs[2 * slot].iov_base;
+            char* output = (char*) iovecs[2 * slot + 1].iov_base;
+            io_uring_sqe* sqe;
+
+            switch (stage) {
+            case OPEN_INPUT:
+                if (cqe.res < 0) {
+                    job.err = ERROR_OPENING_CONFIGURATION_FILE;
+                    start(slot);
+                    break;
+                }
+                at.fd = cqe.res;
+                sqe = queue(fixed ? IORING_OP_READ_FIXED : IORING_OP_READ,
+                            at.fd, buffer, BATCH_BUFFER, slot, READ_INPUT);
+                sqe->buf_index = 2 * slot;
+                break;
+
+            case READ_INPUT:
+                closeFile(slot, CLOSE_INPUT);
+                if (cqe.res < 0)
+                    job.err = ERROR_OPENING_CONFIGURATION_FILE;
+                else if (cqe.res == BATCH_BUFFER)
+                    oversize.push_back(at.job); // May not have read it all
+                else {
+                    at.length = encryptMessage
+                        (base, engines, buffer, cqe.res, output, job.err);
+                    if (!job.err) {
+                        sqe = queue(IORING_OP_OPENAT, AT_FDCWD,
+                                    job.output.c_str(), 0644, slot,
+                                    OPEN_OUTPUT);
+                        sqe->open_flags = O_WRONLY | O_CREAT | O_TRUNC;
+                        break;
+                    }
+                }
+                start(slot);
+                break;
+
+            case OPEN_OUTPUT:
+                if (cqe.res < 0) {
+                    job.err = ERROR_OPENING_CONFIGURATION_FILE;
+                    start(slot);
+                    break;
+                }
+                at.fd = cqe.res;
+                sqe = queue(fixed ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE,
+                            at.fd, output, at.length, slot, WRITE_OUTPUT);
+                sqe->buf_index = 2 * slot + 1;
+                break;
+
+            case WRITE_OUTPUT:
+                if (cqe.res != at.length)
+                    job.err = ERROR_OPENING_CONFIGURATION_FILE;
+                closeFile(slot, CLOSE_OUTPUT);
+                start(slot);
+                break;
+
+            default:
+                break;
+            }
+        }
+    }
+
+    for (size_t job : oversize)
+        encryptBlocking(base, engines, jobs[job]);
+}
+
+
+bool encryptBatch
+(Enigma<> const& base, EngineSelector& engines, vector<BatchJob>& jobs,
+ bool use_ring)
+{
+    atomic<size_t> next_job(0);
+    Ring first;
+    bool ring_used = use_ring && first.setup(2 * BATCH_SLOTS);
+    // Room for every slot's next operation and a close besides
+
+    for (BatchJob& job : jobs)
+        job.err = NO_ERROR;
+
+    auto worker = [&](Ring* ring) {
+        Ring own;
+        if (ring_used && !ring && own.setup(2 * BATCH_SLOTS))
+            ring = &own;
+
+        if (ring)
+            ringWorker(*ring, base, engines, jobs, next_job);
+        else {
+            for (size_t i; (i = next_job++) < jobs.size(); )
+                encryptBlocking(base, engines, jobs[i]);
+        }
+    };
+
+    vector<thread> threads;
+    for (unsigned t = 1; t < thread::hardware_concurrency(); t++)
+        threads.push_back(thread(worker, nullptr));
+    worker(ring_used ? &first : nullptr);
+    for (thread& t : threads)
+        t.join();
+
+    return ring_used;
+}
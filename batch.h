@@ -0,0 +1,45 @@
+/* Batch encryption header file
+ *
+ * This file contains the header file for encrypting many small message
+ * files at once, through io_uring on Linux where it is available.
+ */
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "enigma.h"
+#include "engine.h"
+#include <string>
+#include <vector>
+
+int const BATCH_SLOTS = 128; // Files in flight at once on each thread
+int const BATCH_BUFFER = 16384; // Bytes each file in flight may take up
+
+
+/* 'BatchJob' is one message file to encrypt. Its contents are read as by
+   the main program: whitespace is skipped and a '.' ends the message. The
+   ciphertext is written to 'output' followed by a newline. */
+struct BatchJob {
+    std::string input;
+    std::string output;
+    int err; // As in errors.h, once the job has run
+};
+
+
+bool encryptBatch
+    (Enigma<> const& base, EngineSelector& engines,
+     std::vector<BatchJob>& jobs, bool use_ring);
+/* Precondition:
+   'base' is a configured machine. */
+/* Postcondition:
+   Every job is encrypted from the start positions of 'base' with the
+   engine 'engines' picks for its length, on all hardware threads, and its
+   error code set. If 'use_ring' is true and the kernel supports it, each
+   thread keeps BATCH_SLOTS files in flight through its own io_uring,
+   opening, reading and writing them with registered buffers and
+   encrypting each file as its read completes; files larger than
+   BATCH_BUFFER are done with blocking calls. Otherwise every file is done
+   with blocking calls. True is returned if io_uring was used. */
+
+
+#endif
@@ -0,0 +1,62 @@
+/* Resumable bulk encryption program
+ *
+ * This file contains the main program for encrypting very large files in a
+ * run which can be stopped and carried on. Usage:
+ * './bulk [-i <seconds>] <input> <output> <checkpoint> <plugboard>
+ *  <reflector> <rotorI>...<rotorx> <rotor pos>'
+ * The input is read as by the main program, and its ciphertext written to
+ * the output file followed by a newline. A checkpoint is written every
+ * '-i' seconds, ten by default. Run again with the same arguments after
+ * being stopped, the program checks the output against the checkpoint and
+ * carries on from it. */
+
+#include "errors.h"
+#include "enigma.h"
+#include "engine.h"
+#include "resume.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+
+int main(int argc, char** argv)
+{
+    double interval = CHECKPOINT_SECONDS;
+    int err = NO_ERROR;
+
+    if (argc > 2 && string(argv[1]) == "-i") {
+        interval = atof(argv[2]);
+        argc -= 2;
+        argv += 2; // argv[2] takes the place of the program name
+    }
+
+    if (argc < 6) {
+        cerr << "Too few command line parameters given.\n";
+        cerr << "'./bulk [-i <seconds>] <input> <output> <checkpoint> ";
+        cerr << "<plugboard> <reflector> <rotorI>...<rotorx> <rotor pos>'\n\n";
+        return INSUFFICIENT_NUMBER_OF_PARAMETERS;
+    }
+
+    Enigma<> machine(argc - 7);
+    machine.setConfig(argc - 3, argv + 3, err);
+    // The checkpoint name takes the place of the program name
+    if (err) {
+        cerr << "Error code " << err << ". Exiting...\n";
+        return err;
+    }
+
+    EngineSelector engines;
+    auto start = chrono::steady_clock::now();
+    encryptFile(machine, engines, argv[1], argv[2], argv[3], interval, err);
+    chrono::duration<double> taken = chrono::steady_clock::now() - start;
+    if (err) {
+        cerr << "Error code " << err << ". Exiting...\n";
+        return err;
+    }
+
+    cerr << "Encrypted in " << taken.count() << " s.\n";
+    return NO_ERROR;
+}
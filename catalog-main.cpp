@@ -0,0 +1,101 @@
+/* Cycle-structure catalog program
+ * 
+ * This file contains the main program for the cycle-structure catalog.
+ * Usage:
+ * './catalog build <catalog> <plugboard> <reflector> <rotorI>...<rotorx>'
+ * './catalog query <catalog> <characteristic>'
+ * A characteristic gives the cycle lengths of AD, BE and CF, for example
+ * "13,13/10,10,3,3/9,9,4,4". Each matching rotor order is printed followed
+ * by its start positions. */
+
+#include "errors.h"
+#include "catalog.h"
+#include "enigma.h"
+#include "rotor.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+
+int build(int argc, char** argv)
+{
+    int err = NO_ERROR;
+
+    if (argc < 5 + ROTORS_PER_ORDER) {
+        cerr << "At least " << ROTORS_PER_ORDER << " rotors must be given.\n";
+        return INSUFFICIENT_NUMBER_OF_PARAMETERS;
+    }
+
+    Enigma<> base(ROTORS_PER_ORDER);
+    char* config[3] = {argv[0], argv[3], argv[4]};
+    base.setConfig(3, config, err); // Plugboard and reflector only
+    if (err)
+        return err;
+
+    vector<Rotor> library(argc - 5);
+    vector<string> names;
+    for (int i = 5; i < argc; i++) {
+        library[i-5].load(argv[i], err);
+        if (err)
+            return err;
+        names.push_back(argv[i]);
+    }
+
+    buildCatalog(base, library, names, argv[2], err);
+    return err;
+}
+
+
+int query(char** argv)
+{
+    int err = NO_ERROR, signature;
+    Catalog catalog;
+    vector<CatalogHit> hits;
+
+    if ( (err = parseSignature(argv[3], signature)) )
+        return err;
+
+    catalog.open(argv[2], err);
+    if (err)
+        return err;
+
+    catalog.lookup(signature, hits);
+    for (CatalogHit const& hit : hits) {
+        for (int i = 0; i < ROTORS_PER_ORDER; i++)
+            cout << catalog.rotorName(hit.order[i]) << ' ';
+        for (int i = 0; i < ROTORS_PER_ORDER; i++)
+            cout << ' ' << hit.positions[i];
+        cout << '\n';
+    }
+    cerr << hits.size() << " rotor states have this characteristic.\n";
+
+    return NO_ERROR;
+}
+
+
+int main(int argc, char** argv)
+{
+    int err = NO_ERROR;
+    string mode = (argc > 1) ? argv[1] : "";
+
+    if (mode == "build" && argc >= 5)
+        err = build(argc, argv);
+    else if (mode == "query" && argc == 4)
+        err = query(argv);
+    else {
+        cerr << "Too few command line parameters given.\n";
+        cerr << "'./catalog build <catalog> <plugboard> <reflector> ";
+        cerr << "<rotorI>...<rotorx>'\n";
+        cerr << "'./catalog query <catalog> <characteristic>'\n\n";
+        err = INSUFFICIENT_NUMBER_OF_PARAMETERS;
+    }
+
+    if (err) {
+        cerr << "Error code " << err << ". Exiting...\n";
+        return err;
+    }
+
+    return NO_ERROR;
+}
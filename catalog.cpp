@@ -0,0 +1,387 @@
+/* Cycle-structure catalog functions
+ *
+ * This file contains the definitions for functions to compute and parse
+ * characteristics, to build the catalog file in parallel, and to query it
+ * through a memory mapping.
+ */
+
+#include "errors.h"
+#include "catalog.h"
+#include "enigma.h"
+#include "enumerator.h"
+#include "permutation.h"
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+char const CATALOG_MAGIC[8] = {'E', 'N', 'I', 'G', 'C', 'A', 'T', '1'};
+
+
+/* 'CatalogHeader' starts the file. It is followed by the rotor names (each
+   ending in '\0'), the rotor orders, the offsets and the states, each block
+   padded to a multiple of 4 bytes. */
+struct CatalogHeader {
+    char magic[8];
+    uint32_t no_of_rotors;
+    uint32_t no_of_orders;
+    uint32_t no_of_states;
+    uint32_t names_size; // Including padding
+};
+
+
+static size_t padded(size_t size)
+{
+    return (size + 3) / 4 * 4;
+}
+
+
+static uint64_t partitionKey(int const counts[14])
+{
+    uint64_t key = 0;
+
+    for (int len = 13; len >= 1; len--)
+        key = key * 14 + counts[len];
+    // counts[len] is at most 13, so each length is one base 14 digit
+
+    return key;
+}
+
+
+static unordered_map<uint64_t, int> const& partitionRanks()
+{
+    static unordered_map<uint64_t, int> const ranks = [] {
+        unordered_map<uint64_t, int> table;
+        int counts[14] = {};
+        int rank = 0;
+
+        // Visits the partitions of 13 with parts in decreasing order
+        auto visit = [&](auto& self, int remaining, int largest) -> void {
+            if (remaining == 0) {
+                table[partitionKey(counts)] = rank++;
+                return;
+            }
+            for (int part = min(remaining, largest); part >= 1; part--) {
+                counts[part]++;
+                self(self, remaining - part, part);
+                counts[part]--;
+            }
+        };
+        visit(visit, 13, 13);
+
+        return table;
+    }();
+
+    return ranks;
+}
+
+
+int signatureOf(Permutation const products[3])
+{
+    int signature = 0;
+    vector<int> lengths;
+
+    for (int i = 0; i < 3; i++) {
+        int counts[14] = {};
+        products[i].cycleLengths(lengths);
+        for (size_t j = 0; j < lengths.size(); j += 2)
+            counts[lengths[j]]++; // Cycles come in equal pairs
+        signature = signature * 101 + partitionRanks().at(partitionKey(counts));
+    }
+
+    return signature;
+}
+
+
+int parseSignature(string const& text, int& signature)
+{
+    stringstream groups(text);
+    string group;
+    int no_of_groups = 0;
+
+    signature = 0;
+    while (getline(groups, group, '/')) {
+        stringstream numbers(group);
+        string number;
+        int counts[27] = {}, total = 0;
+
+        while (getline(numbers, number, ',')) {
+            int len = atoi(number.c_str());
+            if (len < 1 || len > 26 || number.find_first_not_of("0123456789")
+                != string::npos) {
+                cerr << "\nInvalid cycle length '" << number << "' given.\n";
+                return INVALID_INDEX;
+            }
+            counts[len]++;
+            total += len;
+        }
+
+        for (int len = 1; len <= 26; len++) {
+            if (counts[len] % 2 || (len > 13 && counts[len]))
+                total = -1; // Each product has its cycles in equal pairs
+            counts[len] /= 2;
+        }
+        if (total != 26) {
+            cerr << "\nCycle lengths '" << group << "' are not the cycles ";
+            cerr << "of a product of two key presses.\n";
+            return INVALID_INDEX;
+        }
+
+        signature = signature * 101 + partitionRanks().at(partitionKey(counts));
+        no_of_groups++;
+    }
+
+    if (no_of_groups != 3) {
+        cerr << "\nCharacteristic '" << text << "' must give three products ";
+        cerr << "separated by '/'.\n";
+        return INSUFFICIENT_NUMBER_OF_PARAMETERS;
+    }
+
+    return NO_ERROR;
+}
+
+
+void buildCatalog
+(Enigma<> const& base, vector<Rotor> const& library,
+ vector<string> const& names, char const filename[], int& err)
+{
+    int no_of_rotors = library.size();
+    uint64_t no_of_states = (uint64_t) no_of_rotors * (no_of_rotors - 1)
+        * (no_of_rotors - 2) * NO_OF_POSITIONS;
+    if (no_of_states > UINT32_MAX) {
+        cerr << "A catalog can hold at most " << MAX_CATALOG_ROTORS;
+        cerr << " rotors; " << no_of_rotors << " given.\n";
+        err = INSUFFICIENT_NUMBER_OF_PARAMETERS;
+        return;
+    } // States are numbered in 32 bits, which also keeps each library
+      // index within the byte it is stored in
+
+    vector<int> order_list;
+    rotorOrders(no_of_rotors, ROTORS_PER_ORDER, order_list);
+    vector<uint8_t> orders(order_list.begin(), order_list.end());
+
+    int no_of_orders = orders.size() / ROTORS_PER_ORDER;
+    vector<uint32_t> signatures((size_t) no_of_orders * NO_OF_POSITIONS);
+    atomic<int> next_order(0);
+    partitionRanks(); // Built before the threads share it
+
+    auto worker = [&]() {
+        Enigma<> machine(base);
+        int positions[ROTORS_PER_ORDER];
+        Permutation presses[6], products[3];
+
+        for (int order; (order = next_order++) < no_of_orders; ) {
+            for (int i = 0; i < ROTORS_PER_ORDER; i++)
+                machine.setRotor
+                    (i, library[orders[order * ROTORS_PER_ORDER + i]]);
+
+            for (int key = 0; key < NO_OF_POSITIONS; key++) {
+                for (int i = ROTORS_PER_ORDER - 1, k = key; i >= 0;
+                     i--, k /= 26)
+                    positions[i] = k % 26;
+                machine.setPositions(positions);
+
+                for (int press = 0; press < 6; press++) {
+                    machine.seek(1); // Each key press turns the rotors first
+                    presses[press] = machine.permutation();
+                }
+                for (int i = 0; i < 3; i++)
+                    products[i] = presses[i].then(presses[i + 3]);
+
+                signatures[(size_t) order * NO_OF_POSITIONS + key] =
+                    signatureOf(products);
+            }
+        }
+    };
+
+    vector<thread> threads;
+    for (unsigned t = 1; t < thread::hardware_concurrency(); t++)
+        threads.push_back(thread(worker));
+    worker();
+    for (thread& t : threads)
+        t.join();
+
+    // Counting sort of the states by signature
+    vector<uint32_t> offsets(NO_OF_SIGNATURES + 1, 0);
+    for (uint32_t signature : signatures)
+        offsets[signature + 1]++;
+    for (int s = 0; s < NO_OF_SIGNATURES; s++)
+        offsets[s + 1] += offsets[s];
+    vector<uint32_t> states(signatures.size());
+    vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t state = 0; state < signatures.size(); state++)
+        states[fill[signatures[state]]++] = state;
+
+    string name_block;
+    for (string const& name : names)
+        name_block += name + '\0';
+    name_block.resize(padded(name_block.size()), '\0');
+    orders.resize(padded(orders.size()), 0);
+
+    CatalogHeader header;
+    memcpy(header.magic, CATALOG_MAGIC, sizeof(header.magic));
+    header.no_of_rotors = no_of_rotors;
+    header.no_of_orders = no_of_orders;
+    header.no_of_states = states.size();
+    header.names_size = name_block.size();
+
+    string temp_name = string(filename) + ".tmp";
+    ofstream out(temp_name, ios::binary);
+    out.write((char const*) &header, sizeof(header));
+    out.write(name_block.data(), name_block.size());
+    out.write((char const*) orders.data(), orders.size());
+    out.write((char const*) offsets.data(), offsets.size() * sizeof(uint32_t));
+    out.write((char const*) states.data(), states.size() * sizeof(uint32_t));
+    out.close();
+
+    if (out.fail() || rename(temp_name.c_str(), filename)) {
+        remove(temp_name.c_str());
+        cerr << "Error writing '" << filename << "'.\n";
+        err = ERROR_OPENING_CONFIGURATION_FILE;
+        return;
+    }
+    // Written to a temporary file and renamed, so a reader never maps a
+    // half written catalog
+
+    err = NO_ERROR;
+}
+
+
+static bool validLayout(CatalogHeader const& header, size_t file_size)
+{
+    size_t orders_size =
+        padded((size_t) header.no_of_orders * ROTORS_PER_ORDER);
+    size_t expected = sizeof(CatalogHeader) + (size_t) header.names_size
+        + orders_size + (NO_OF_SIGNATURES + 1 + (size_t) header.no_of_states)
+        * sizeof(uint32_t);
+
+    return header.no_of_rotors <= MAX_CATALOG_ROTORS &&
+        header.no_of_orders <= header.no_of_rotors * header.no_of_rotors
+        * header.no_of_rotors && header.names_size % 4 == 0 &&
+        file_size == expected;
+} // Each count is bounded before it is used, so 'expected' cannot overflow
+
+
+Catalog::Catalog()
+{
+    map_ = nullptr;
+    map_size_ = 0;
+    no_of_orders_ = 0;
+}
+
+
+Catalog::~Catalog()
+{
+    close();
+}
+
+
+void Catalog::close()
+{
+    if (map_)
+        munmap((void*) map_, map_size_);
+    map_ = nullptr;
+    map_size_ = 0;
+    names_.clear();
+}
+
+
+void Catalog::open(char const filename[], int& err)
+{
+    int fd = ::open(filename, O_RDONLY);
+    struct stat info;
+
+    close();
+    if (fd < 0 || fstat(fd, &info)) {
+        cerr << "Error opening '" << filename << "'.\n";
+        err = ERROR_OPENING_CONFIGURATION_FILE;
+        if (fd >= 0)
+            ::close(fd);
+        return;
+    }
+
+    map_size_ = info.st_size;
+    map_ = mmap(nullptr, map_size_, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd); // The mapping stays valid
+    if (map_ == MAP_FAILED)
+        map_ = nullptr;
+
+    CatalogHeader const* header = (CatalogHeader const*) map_;
+    if (!map_ || map_size_ < sizeof(CatalogHeader) ||
+        memcmp(header->magic, CATALOG_MAGIC, 8) ||
+        !validLayout(*header, map_size_)) {
+        cerr << "'" << filename << "' is not a catalog file.\n";
+        err = ERROR_OPENING_CONFIGURATION_FILE;
+        close();
+        return;
+    }
+
+    char const* at = (char const*) (header + 1);
+    char const* names_end = at + header->names_size;
+    names_.clear();
+    for (uint32_t i = 0; i < header->no_of_rotors && at < names_end; i++) {
+        char const* end = (char const*) memchr(at, '\0', names_end - at);
+        if (!end)
+            break;
+        names_.push_back(string(at, end));
+        at = end + 1;
+    }
+    orders_ = (uint8_t const*) names_end;
+    offsets_ = (uint32_t const*)
+        (names_end + padded((size_t) header->no_of_orders * ROTORS_PER_ORDER));
+    states_ = offsets_ + NO_OF_SIGNATURES + 1;
+    no_of_orders_ = header->no_of_orders;
+
+    bool valid = names_.size() == header->no_of_rotors;
+    for (size_t i = 0; valid && i < no_of_orders_ * ROTORS_PER_ORDER; i++)
+        valid = orders_[i] < header->no_of_rotors;
+    for (int s = 0; valid && s < NO_OF_SIGNATURES; s++)
+        valid = offsets_[s] <= offsets_[s + 1];
+    if (!valid || offsets_[0] != 0 ||
+        offsets_[NO_OF_SIGNATURES] != header->no_of_states) {
+        cerr << "'" << filename << "' is corrupt.\n";
+        err = ERROR_OPENING_CONFIGURATION_FILE;
+        close();
+        return;
+    } // The states themselves are checked as they are looked up, rather
+      // than paging in the whole file here
+
+    err = NO_ERROR;
+}
+
+
+void Catalog::lookup(int signature, vector<CatalogHit>& hits) const
+{
+    hits.clear();
+
+    for (uint32_t i = offsets_[signature]; i < offsets_[signature + 1]; i++) {
+        CatalogHit hit;
+        uint32_t order = states_[i] / NO_OF_POSITIONS;
+        int key = states_[i] % NO_OF_POSITIONS;
+        if (order >= no_of_orders_)
+            continue; // Corrupt, so not a state of any order
+
+        for (int r = ROTORS_PER_ORDER - 1; r >= 0; r--, key /= 26) {
+            hit.order[r] = orders_[order * ROTORS_PER_ORDER + r];
+            hit.positions[r] = key % 26;
+        }
+        hits.push_back(hit);
+    }
+}
+
+
+string const& Catalog::rotorName(int i) const
+{
+    return names_[i];
+}
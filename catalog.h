@@ -0,0 +1,114 @@
+/* Cycle-structure catalog header file
+ *
+ * This file contains the header file for the catalog of cycle structures
+ * used to analyse doubly enciphered message keys.
+ */
+
+#ifndef CATALOG_H
+#define CATALOG_H
+
+#include "enigma.h"
+#include "rotor.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+/* A message key enciphered twice at the start of a message gives the
+   products AD, BE and CF of the machine permutations at key presses 1 and 4,
+   2 and 5, and 3 and 6. Their cycle lengths (the characteristic) depend only
+   on the rotor order and start positions, not on the plugboard. Since every
+   machine permutation is an involution, the cycles of each product come in
+   equal pairs, so each product is described by a partition of 13, and the
+   characteristic by three of them. There are 101 partitions of 13, so a
+   characteristic is a number below 101^3: its signature.
+
+   The catalog file holds, for every rotor order of ROTORS_PER_ORDER rotors
+   from a library and every start position, a state number, grouped by
+   signature. A table of offsets indexed by signature makes each lookup a
+   single array access on the memory mapped file. */
+
+int const ROTORS_PER_ORDER = 3;
+int const NO_OF_POSITIONS = 26 * 26 * 26; // Start positions per rotor order
+int const NO_OF_SIGNATURES = 101 * 101 * 101;
+int const MAX_CATALOG_ROTORS = 63; // Most whose states number in 32 bits
+
+
+/* 'CatalogHit' is one rotor state which produces a given characteristic. */
+struct CatalogHit {
+    int order[ROTORS_PER_ORDER]; // Library index of each rotor, left first
+    int positions[ROTORS_PER_ORDER]; // Start positions, left first
+};
+
+
+int signatureOf(Permutation const products[3]);
+/* Precondition:
+   'products' holds AD, BE and CF. */
+/* Postcondition:
+   The signature of their cycle structure is returned. */
+
+int parseSignature(std::string const& text, int& signature);
+/* Precondition:
+   'text' gives the cycle lengths of AD, BE and CF separated by '/', each
+   as comma separated numbers, e.g. "13,13/10,10,3,3/9,9,4,4". */
+/* Postcondition:
+   If 'text' is not a valid characteristic, an error message is displayed
+   and the error code returned. Otherwise, 'signature' is set and 0 is
+   returned. */
+
+void buildCatalog
+    (Enigma<> const& base, std::vector<Rotor> const& library,
+     std::vector<std::string> const& names, char const filename[], int& err);
+/* Precondition:
+   'base' has its plugboard and reflector set and room for ROTORS_PER_ORDER
+   rotors, 'library' holds the rotors to choose from with their file names
+   in 'names', and 'err' is the error code, currently set to 0. */
+/* Postcondition:
+   Every rotor order is simulated on all hardware threads, and the catalog
+   is written to 'filename'. If the file cannot be written, an error
+   message is displayed and the error code changed. */
+
+
+/* The 'Catalog' class is a catalog file mapped into memory for queries. */
+class Catalog {
+ public:
+    Catalog(); // Constructor
+    ~Catalog(); // Destructor
+
+    void open(char const filename[], int& err);
+    /* Precondition:
+       'err' is the error code, currently set to 0. */
+    /* Postcondition:
+       If the file cannot be opened, is not a catalog, or its sizes, names,
+       rotor orders or offsets are inconsistent, an error message is
+       displayed and the error code changed. Otherwise, the file is mapped
+       and err = 0. */
+
+    void lookup(int signature, std::vector<CatalogHit>& hits) const;
+    /* Precondition:
+       The catalog is open, and 'signature' is below NO_OF_SIGNATURES. */
+    /* Postcondition:
+       'hits' holds every rotor state producing the characteristic. */
+
+    std::string const& rotorName(int i) const;
+    /* Postcondition:
+       The file name of library rotor 'i' is returned. */
+
+    void close();
+    /* Postcondition:
+       The file is unmapped, if one was open. */
+
+ private:
+    void const* map_; // Whole file, or nullptr if not open
+    std::size_t map_size_;
+    std::uint32_t const* offsets_; // Per signature, into 'states_'
+    std::uint32_t const* states_; // order * NO_OF_POSITIONS + key
+    std::uint8_t const* orders_; // ROTORS_PER_ORDER library indices each
+    std::size_t no_of_orders_;
+    std::vector<std::string> names_;
+
+    Catalog(Catalog const&); // Not copyable, as it owns the mapping
+};
+
+
+#endif
@@ -0,0 +1,56 @@
+/* Crib placement program
+ * 
+ * This file contains the main program for the crib finder. Usage:
+ * './crib <ciphertext> <crib1> <crib2>...<cribx>'
+ * Every offset at which a crib may be placed is printed on its own line. */
+
+#include "errors.h"
+#include "crib.h"
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+
+int main(int argc, char** argv)
+{
+    CribFinder finder;
+    vector<long> offsets;
+    int err = NO_ERROR;
+
+    if (argc < 3) {
+        cerr << "Too few command line parameters given.\n";
+        cerr << "'./crib <ciphertext> <crib1> <crib2>...<cribx>'\n\n";
+        return INSUFFICIENT_NUMBER_OF_PARAMETERS;
+    }
+
+    for (int i = 2; i < argc; i++) {
+        if ( (err = finder.invalidCrib(argv[i])) ) {
+            cerr << "Error code " << err << ". Exiting...\n";
+            return err;
+        }
+    }
+
+    ifstream ct_file(argv[1]);
+    if (ct_file.fail()) {
+        cerr << "Error opening '" << argv[1] << "'.\n";
+        return ERROR_OPENING_CONFIGURATION_FILE;
+    }
+
+    finder.setCiphertext(ct_file, err);
+    if (err) {
+        cerr << "Error code " << err << ". Exiting...\n";
+        return err;
+    }
+
+    for (int i = 2; i < argc; i++) {
+        finder.place(argv[i], offsets);
+        for (long offset : offsets)
+            cout << argv[i] << ' ' << offset << '\n';
+        cerr << "Crib '" << argv[i] << "': " << offsets.size();
+        cerr << " possible placements in " << finder.length() << " letters.\n";
+    }
+
+    return NO_ERROR;
+}
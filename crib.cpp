@@ -0,0 +1,111 @@
+/* Crib finder member functions
+ *
+ * This file contains the definitions for member functions to read in a
+ * ciphertext and to find every possible placement of a crib within it.
+ */
+
+#include "errors.h"
+#include "crib.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+
+void CribFinder::setCiphertext(istream& ins, int& err)
+{
+    string text;
+    char ch;
+
+    ins >> ws >> ch;
+    while (ch != '.' && !ins.eof()) {
+        if (ch < 'A' || ch > 'Z') {
+            cerr << "\n'" << ch << "' is not a valid ciphertext character.\n";
+            cerr << "The ciphertext may only contain characters from A - Z.\n";
+            err = INVALID_INPUT_CHARACTER;
+            return;
+        }
+        text += ch;
+        ins >> ws >> ch;
+    }
+
+    length_ = text.length();
+    long words = (length_ + 63) / 64 + 1;
+    // One extra zero word, so shifted reads never run off the end
+    for (int l = 0; l < 26; l++)
+        masks_[l].assign(words, 0);
+
+    for (long x = 0; x < length_; x++)
+        masks_[text[x] - 'A'][x / 64] |= uint64_t(1) << (x % 64);
+
+    err = NO_ERROR;
+}
+
+
+void CribFinder::place(string const& crib, vector<long>& offsets) const
+{
+    long crib_len = crib.length();
+    long last = length_ - crib_len; // Last offset the crib fits at
+
+    offsets.clear();
+    if (crib_len == 0 || last < 0)
+        return;
+
+    long words = last / 64 + 1;
+    vector<uint64_t> clash(words, 0);
+    // Bit o of clash set <=> some crib letter at offset o meets itself
+
+    for (long j = 0; j < crib_len; j++) {
+        uint64_t const* mask = masks_[crib[j] - 'A'].data() + j / 64;
+        int shift = j % 64;
+
+        // Shifting the letter mask down by j lines ciphertext letter o+j up
+        // with offset o, for 64 offsets at a time
+        if (shift == 0) {
+            for (long w = 0; w < words; w++)
+                clash[w] |= mask[w];
+        } else {
+            for (long w = 0; w < words; w++)
+                clash[w] |= (mask[w] >> shift) | (mask[w+1] << (64 - shift));
+        }
+    }
+
+    for (long w = 0; w < words; w++) {
+        uint64_t fits = ~clash[w];
+        if (w == words - 1 && (last + 1) % 64)
+            fits &= (uint64_t(1) << ((last + 1) % 64)) - 1;
+        // Offsets beyond 'last' are masked off in the final word
+
+        while (fits) {
+            offsets.push_back(w * 64 + __builtin_ctzll(fits));
+            fits &= fits - 1; // Clears the lowest set bit
+        }
+    }
+}
+
+
+long CribFinder::length() const
+{
+    return length_;
+}
+
+
+int CribFinder::invalidCrib(string const& crib) const
+{
+    if (crib.empty()) {
+        cerr << "\nEmpty crib given on the command line.\n";
+        return INVALID_INPUT_CHARACTER;
+    }
+
+    for (char ch : crib) {
+        if (ch < 'A' || ch > 'Z') {
+            cerr << "\n'" << ch << "' in crib '" << crib;
+            cerr << "' is not a valid input character.\n";
+            cerr << "You may only enter characters from A - Z.\n";
+            return INVALID_INPUT_CHARACTER;
+        }
+    }
+
+    return NO_ERROR;
+}
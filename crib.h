@@ -0,0 +1,57 @@
+/* Crib placement header file
+ *
+ * This file contains the header file for the crib finder class.
+ */
+
+#ifndef CRIB_H
+#define CRIB_H
+
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <vector>
+
+
+/* The 'CribFinder' class holds a ciphertext as one bitmask per letter. Since
+   the reflector never maps a letter to itself, the machine can never encrypt
+   a letter to itself, so a crib can only sit at offsets where none of its
+   letters coincides with the ciphertext. The bitmasks let every offset be
+   tested at once, 64 offsets per word. */
+class CribFinder {
+ public:
+    void setCiphertext(std::istream& ins, int& err);
+    /* Precondition:
+       'ins' is the input stream holding the ciphertext, and 'err' is the
+       error code, currently set to 0. */
+    /* Postcondition:
+       If an error is encountered, the function immediately returns with the
+       error code changed. Otherwise, every letter up to eof or '.' is read
+       in, whitespace skipped, the letter masks are set, and err = 0. */
+
+    void place(std::string const& crib, std::vector<long>& offsets) const;
+    /* Precondition:
+       The ciphertext is set, and 'crib' contains only letters A - Z. */
+    /* Postcondition:
+       'offsets' holds, in increasing order, every offset at which the crib
+       fits the ciphertext without any letter encrypting to itself. */
+
+    long length() const;
+    /* Postcondition:
+       The number of ciphertext letters is returned. */
+
+    int invalidCrib(std::string const& crib) const;
+    /* Precondition:
+       'crib' is one of the cribs given on the command line. */
+    /* Postcondition:
+       If 'crib' is empty or contains a character other than an upper case
+       letter, an error message is displayed and the error code returned.
+       Otherwise, 0 is returned. */
+
+ private:
+    std::vector<std::uint64_t> masks_[26];
+    // Bit x of masks_[l] set <=> ciphertext letter x is l
+    long length_ = 0;
+};
+
+
+#endif
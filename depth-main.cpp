@@ -0,0 +1,107 @@
+/* Depth finder program
+ * 
+ * This file contains the main program for finding messages in depth. Usage:
+ * './depth [-a] [-q <gram>] [-f <false pairs>]'
+ * The ciphertext files are named on standard input, one per line. Each
+ * group of messages found in depth is printed on one line, as each file
+ * followed by '@' and the key presses its start is ahead of the group's
+ * earliest. '-a' compares every pair of messages at offset 0 instead of
+ * using the gram index, '-q' sets the gram length (default 5), and '-f'
+ * the number of unrelated pairs which may be let through by chance
+ * (default 0.01). */
+
+#include "errors.h"
+#include "depth.h"
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+
+int readCiphertext(string const& filename, string& text)
+{
+    ifstream in(filename);
+    char ch;
+
+    if (in.fail()) {
+        cerr << "Error opening '" << filename << "'.\n";
+        return ERROR_OPENING_CONFIGURATION_FILE;
+    }
+
+    text.clear();
+    while (in >> ch && ch != '.') {
+        if (ch < 'A' || ch > 'Z') {
+            cerr << "'" << ch << "' in '" << filename << "' is not a valid ";
+            cerr << "input character.\n";
+            return INVALID_INPUT_CHARACTER;
+        }
+        text += ch;
+    }
+
+    return NO_ERROR;
+}
+
+
+int main(int argc, char** argv)
+{
+    bool all_pairs = false;
+    int gram = DEPTH_GRAM;
+    double false_pairs = FALSE_PAIRS;
+
+    for (int i = 1; i < argc; i++) {
+        string option = argv[i];
+        if (option == "-a")
+            all_pairs = true;
+        else if (option == "-q" && i + 1 < argc)
+            gram = atoi(argv[++i]);
+        else if (option == "-f" && i + 1 < argc)
+            false_pairs = atof(argv[++i]);
+        else {
+            cerr << "Unknown option '" << option << "'.\n";
+            cerr << "'./depth [-a] [-q <gram>] [-f <false pairs>]'\n\n";
+            return INSUFFICIENT_NUMBER_OF_PARAMETERS;
+        }
+    }
+    if (gram < 1 || gram > MAX_GRAM || false_pairs <= 0) {
+        cerr << "The gram length must be between 1 and " << MAX_GRAM;
+        cerr << ", and the false pairs above 0.\n";
+        return INVALID_INDEX;
+    }
+
+    vector<string> names, texts;
+    string name, text;
+    while (getline(cin, name)) {
+        if (!name.empty() && !readCiphertext(name, text)) {
+            names.push_back(name);
+            texts.push_back(text);
+        } // Files which cannot be read are reported and left out
+    }
+
+    vector<DepthPair> pairs;
+    if (all_pairs)
+        allCandidates(texts, pairs);
+    else
+        indexedCandidates(texts, gram, pairs);
+    long candidates = pairs.size();
+    checkCandidates(texts, all_pairs ? 0 : gram,
+                    log10(max(candidates, 1L) / false_pairs), pairs);
+
+    vector<vector<pair<int, long> > > groups;
+    depthGroups(texts.size(), pairs, groups);
+    for (auto const& group : groups) {
+        for (size_t i = 0; i < group.size(); i++)
+            cout << (i ? " " : "") << names[group[i].first] << '@'
+                 << group[i].second;
+        cout << '\n';
+    }
+
+    cerr << texts.size() << " messages, " << candidates << " candidate ";
+    cerr << "pairs, " << pairs.size() << " in depth, " << groups.size();
+    cerr << " groups.\n";
+
+    return NO_ERROR;
+}
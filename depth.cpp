@@ -0,0 +1,325 @@
+/* Depth finder functions
+ *
+ * This file contains the definitions for functions to index, check and
+ * group messages in depth.
+ */
+
+#include "depth.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+
+/* 'Posting' is one gram of one message, at the letter it starts from. */
+struct Posting {
+    uint32_t gram;
+    uint32_t message;
+    uint32_t position;
+
+    bool operator<(Posting const& other) const
+    {
+        if (gram != other.gram)
+            return gram < other.gram;
+        if (message != other.message)
+            return message < other.message;
+        return position < other.position;
+    }
+};
+
+
+static bool pairBefore(DepthPair const& a, DepthPair const& b)
+{
+    if (a.first != b.first)
+        return a.first < b.first;
+    if (a.second != b.second)
+        return a.second < b.second;
+    return a.offset < b.offset;
+}
+
+
+static bool samePair(DepthPair const& a, DepthPair const& b)
+{
+    return a.first == b.first && a.second == b.second && a.offset == b.offset;
+}
+
+
+static void sortUnique(vector<DepthPair>& pairs)
+{
+    sort(pairs.begin(), pairs.end(), pairBefore);
+    pairs.erase(unique(pairs.begin(), pairs.end(), samePair), pairs.end());
+}
+
+
+static unsigned noOfThreads()
+{
+    return max(1u, thread::hardware_concurrency());
+}
+
+
+long coincidences(char const a[], char const b[], long length)
+{
+    long count = 0, i = 0;
+
+#if defined(__AVX2__)
+    for (; i + 32 <= length; i += 32) {
+        __m256i x = _mm256_loadu_si256((__m256i const*) (a + i));
+        __m256i y = _mm256_loadu_si256((__m256i const*) (b + i));
+        count += __builtin_popcount(_mm256_movemask_epi8
+                                    (_mm256_cmpeq_epi8(x, y)));
+    }
+#elif defined(__SSE2__)
+    for (; i + 16 <= length; i += 16) {
+        __m128i x = _mm_loadu_si128((__m128i const*) (a + i));
+        __m128i y = _mm_loadu_si128((__m128i const*) (b + i));
+        count += __builtin_popcount(_mm_movemask_epi8(_mm_cmpeq_epi8(x, y)));
+    }
+#endif
+    for (; i < length; i++)
+        count += a[i] == b[i];
+
+    return count;
+}
+
+
+void indexedCandidates
+(vector<string> const& texts, int gram, vector<DepthPair>& pairs)
+{
+    unsigned parts = noOfThreads();
+    vector<vector<DepthPair> > found(parts);
+    uint32_t span = 1;
+
+    for (int i = 0; i < gram; i++)
+        span *= 26;
+
+    auto worker = [&](unsigned part) {
+        vector<Posting> postings;
+
+        for (size_t m = 0; m < texts.size(); m++) {
+            string const& text = texts[m];
+            uint64_t value = 0; // Below 'span', but not once shifted
+            for (size_t p = 0; p < text.size(); p++) {
+                value = (value * 26 + (text[p] - 'A')) % span;
+                if (p + 1 >= size_t(gram) && value % parts == part) {
+                    Posting posting = {uint32_t(value), uint32_t(m),
+                                       uint32_t(p + 1 - gram)};
+                    postings.push_back(posting);
+                }
+            }
+        } // Each thread indexes its own share of the grams, so needs no lock
+
+        sort(postings.begin(), postings.end());
+
+        for (size_t begin = 0, end; begin < postings.size(); begin = end) {
+            end = begin + 1;
+            while (end < postings.size() &&
+                   postings[end].gram == postings[begin].gram)
+                end++;
+            if (end - begin > size_t(MAX_BUCKET))
+                continue; // Too common to tell anything
+
+            for (size_t i = begin; i < end; i++) {
+                for (size_t j = i + 1; j < end; j++) {
+                    if (postings[i].message == postings[j].message)
+                        continue;
+                    DepthPair pair = {int(postings[i].message),
+                                      int(postings[j].message),
+                                      int(postings[i].position) -
+                                      int(postings[j].position), 0, 0, 0};
+                    found[part].push_back(pair);
+                }
+            }
+        }
+        sortUnique(found[part]);
+    };
+
+    vector<thread> threads;
+    for (unsigned part = 1; part < parts; part++)
+        threads.push_back(thread(worker, part));
+    worker(0);
+    for (thread& t : threads)
+        t.join();
+
+    pairs.clear();
+    for (vector<DepthPair> const& part : found)
+        pairs.insert(pairs.end(), part.begin(), part.end());
+    sortUnique(pairs);
+}
+
+
+void allCandidates(vector<string> const& texts, vector<DepthPair>& pairs)
+{
+    pairs.clear();
+    for (size_t a = 0; a < texts.size(); a++) {
+        for (size_t b = a + 1; b < texts.size(); b++) {
+            DepthPair pair = {int(a), int(b), 0, 0, 0, 0};
+            pairs.push_back(pair);
+        }
+    }
+}
+
+
+static double logTail(long n, long k, double p)
+{
+    if (k <= n * p)
+        return 0; // No better than chance, which is all that matters here
+
+    double log_first = lgamma(n + 1.0) - lgamma(k + 1.0) - lgamma(n - k + 1.0)
+                       + k * log(p) + (n - k) * log1p(-p);
+    double sum = 1, term = 1;
+    for (long i = k; i < n && term > 1e-15 * sum; i++) {
+        term *= double(n - i) / (i + 1) * p / (1 - p);
+        sum += term;
+    } // Terms relative to the first, which fall away quickly past n * p
+
+    return log_first + log(sum);
+}
+
+
+void checkCandidates
+(vector<string> const& texts, int given, double min_significance,
+ vector<DepthPair>& pairs)
+{
+    atomic<size_t> next_pair(0);
+    double const p = 1.0 / 26; // Rate at which unrelated letters coincide
+
+    auto worker = [&]() {
+        for (size_t i; (i = next_pair++) < pairs.size(); ) {
+            DepthPair& pair = pairs[i];
+            string const& first = texts[pair.first];
+            string const& second = texts[pair.second];
+            long from_first = max(pair.offset, 0);
+            long from_second = max(-pair.offset, 0);
+
+            pair.overlap = min<long>(long(first.size()) - from_first,
+                                     long(second.size()) - from_second);
+            if (pair.overlap < MIN_OVERLAP) {
+                pair.significance = 0;
+                continue;
+            }
+            pair.matches = coincidences(first.data() + from_first,
+                                        second.data() + from_second,
+                                        pair.overlap);
+            pair.significance = -logTail(pair.overlap - given,
+                                         pair.matches - given, p) / log(10.0);
+            // The letters which put the pair forward are not evidence
+        }
+    };
+
+    vector<thread> threads;
+    for (unsigned t = 1; t < noOfThreads(); t++)
+        threads.push_back(thread(worker));
+    worker();
+    for (thread& t : threads)
+        t.join();
+
+    auto weak = [&](DepthPair const& pair) {
+        return pair.overlap < MIN_OVERLAP ||
+               pair.significance < min_significance;
+    };
+    pairs.erase(remove_if(pairs.begin(), pairs.end(), weak), pairs.end());
+    sort(pairs.begin(), pairs.end(),
+         [](DepthPair const& a, DepthPair const& b)
+         { return a.significance > b.significance; });
+}
+
+
+/* 'DepthSets' is a union-find over messages which also keeps, for each
+   message, its start relative to the root of its set. */
+class DepthSets {
+ public:
+    DepthSets(int size) : parent_(size), size_(size, 1), start_(size, 0)
+    {
+        for (int i = 0; i < size; i++)
+            parent_[i] = i;
+    }
+
+    int find(int x)
+    {
+        int root = x;
+        long start = 0;
+
+        while (parent_[root] != root) {
+            start += start_[root];
+            root = parent_[root];
+        }
+        while (parent_[x] != root) {
+            int next = parent_[x];
+            long rest = start - start_[x];
+            start_[x] = start;
+            parent_[x] = root;
+            start = rest;
+            x = next;
+        } // Every message on the way now points straight at the root
+
+        return root;
+    }
+
+    long start(int x)
+    {
+        find(x);
+        return parent_[x] == x ? 0 : start_[x];
+    }
+
+    void join(int a, int b, long offset)
+    {
+        int root_a = find(a), root_b = find(b);
+        long shift = offset + start(a) - start(b); // Of root_b from root_a
+
+        if (root_a == root_b)
+            return; // Already joined, perhaps at a conflicting offset
+        if (size_[root_a] < size_[root_b]) {
+            swap(root_a, root_b);
+            shift = -shift;
+        }
+        parent_[root_b] = root_a;
+        start_[root_b] = shift;
+        size_[root_a] += size_[root_b];
+    }
+
+ private:
+    vector<int> parent_;
+    vector<int> size_;
+    vector<long> start_; // Relative to parent_
+};
+
+
+void depthGroups
+(int no_of_texts, vector<DepthPair> const& pairs,
+ vector<vector<pair<int, long> > >& groups)
+{
+    DepthSets sets(no_of_texts);
+    map<int, vector<pair<int, long> > > by_root;
+
+    for (DepthPair const& pair : pairs)
+        sets.join(pair.first, pair.second, pair.offset);
+
+    for (int i = 0; i < no_of_texts; i++)
+        by_root[sets.find(i)].push_back(make_pair(i, sets.start(i)));
+
+    groups.clear();
+    for (auto& entry : by_root) {
+        vector<pair<int, long> >& group = entry.second;
+        if (group.size() < 2)
+            continue;
+
+        sort(group.begin(), group.end(),
+             [](pair<int, long> const& a, pair<int, long> const& b)
+             { return a.second < b.second ||
+                      (a.second == b.second && a.first < b.first); });
+        long earliest = group[0].second;
+        for (auto& member : group)
+            member.second -= earliest;
+        groups.push_back(group);
+    }
+}
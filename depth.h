@@ -0,0 +1,96 @@
+/* Depth finder header file
+ *
+ * This file contains the header file for finding messages in depth, i.e.
+ * enciphered from the same machine state, across a corpus of intercepts.
+ */
+
+#ifndef DEPTH_H
+#define DEPTH_H
+
+#include <string>
+#include <utility>
+#include <vector>
+
+int const DEPTH_GRAM = 5; // Letters in each indexed gram, by default
+int const MAX_GRAM = 6; // So that a gram fits in 32 bits
+int const MAX_BUCKET = 256; // Grams shared by more postings are not indexed
+long const MIN_OVERLAP = 20; // Letters two messages must share to be tested
+double const FALSE_PAIRS = 0.01; // Unrelated pairs expected to pass, default
+
+
+/* Two messages in depth are enciphered by the same permutation at each
+   aligned letter, so their letters coincide exactly where their plaintexts
+   do: about 1 in 15 letters for German or English, against 1 in 26 for
+   unrelated messages. A message enciphered from a state 'offset' key
+   presses further on is in depth at that offset.
+
+   Comparing every pair of messages at every offset is too slow for a large
+   corpus, so candidates are found through an index instead. Every gram of
+   'gram' letters in every message is posted under its letters; two messages
+   which share a gram are put forward at the offset the gram's positions
+   imply. Messages in depth share grams wherever their plaintexts repeat a
+   phrase at the same alignment, as headers and stock phrases do, while
+   unrelated messages rarely share one of five letters. Each candidate is
+   then checked by counting coincidences over the whole overlap. */
+
+
+/* 'DepthPair' is two messages, and the offset of 'second' against 'first':
+   letter i of 'second' lines up with letter i + offset of 'first'. */
+struct DepthPair {
+    int first;
+    int second;
+    int offset;
+    long overlap; // Letters compared, once checked
+    long matches; // Of which coincided
+    double significance; // -log10 of the chance unrelated messages match so
+};
+
+
+long coincidences(char const a[], char const b[], long length);
+/* Postcondition:
+   The number of places in which the 'length' letters of 'a' and 'b' are
+   equal is returned. Counted 32 or 16 letters at a time where the build
+   machine has AVX2 or SSE2. */
+
+void indexedCandidates
+    (std::vector<std::string> const& texts, int gram,
+     std::vector<DepthPair>& pairs);
+/* Precondition:
+   'texts' holds each message as letters A - Z, and 'gram' is between 1
+   and MAX_GRAM. */
+/* Postcondition:
+   'pairs' holds, once each, every pair of messages and offset put forward
+   by the gram index, built and searched on all hardware threads. */
+
+void allCandidates
+    (std::vector<std::string> const& texts, std::vector<DepthPair>& pairs);
+/* Postcondition:
+   'pairs' holds every pair of messages at offset 0, for corpora small
+   enough to compare exhaustively. */
+
+void checkCandidates
+    (std::vector<std::string> const& texts, int given,
+     double min_significance, std::vector<DepthPair>& pairs);
+/* Precondition:
+   Every pair was put forward because 'given' of its letters coincide, so
+   these are left out of its score: the gram length for indexed candidates,
+   or 0. */
+/* Postcondition:
+   Each pair has been checked on all hardware threads, and only those
+   overlapping by at least MIN_OVERLAP letters with a significance of at
+   least 'min_significance' are left, best first. Checking n candidates
+   with log10(n / f) lets about f unrelated pairs through. */
+
+void depthGroups
+    (int no_of_texts, std::vector<DepthPair> const& pairs,
+     std::vector<std::vector<std::pair<int, long> > >& groups);
+/* Precondition:
+   'pairs' is ordered best first. */
+/* Postcondition:
+   'groups' holds every set of two or more messages joined by the pairs,
+   each as (message, offset) with offsets measured from the earliest
+   message in the group, in order of offset. A pair implying an offset
+   which conflicts with better pairs already joined is ignored. */
+
+
+#endif
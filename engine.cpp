@@ -0,0 +1,333 @@
+/* Encryption engine functions
+ *
+ * This file contains the definitions for the encryption engines and the
+ * engine selector's member functions.
+ */
+
+#include "engine.h"
+#include "keystream.h"
+#include "permutation.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <vector>
+
+using namespace std;
+
+int const CALIBRATION_RUNS = 3; // Best of, to ride out interruptions
+int const KEYSTREAM_BLOCK = 64; // Permutations generated at a time
+
+
+static void referenceEngine
+(Enigma<>& machine, char const input[], char output[], long length)
+{
+    int err = 0;
+
+    machine.encrypt(input, output, length, err);
+}
+
+
+static void coreEngine
+(Enigma<>& machine, char const input[], char output[], long length)
+{
+    int n = machine.rotorCount();
+    vector<int> positions(n), composed; // Positions 'core' was composed at
+    vector<Permutation> inner, inner_inverse; // [26 * i + p]: rotor i at p
+    Permutation entry[26], exit[26], core;
+
+    if (n == 0) {
+        referenceEngine(machine, input, output, length);
+        return;
+    }
+
+    Rotor const& right = machine.rotor(n - 1);
+    for (int p = 0; p < 26; p++) {
+        entry[p] = machine.plugboard().then(right.permutation(p));
+        exit[p] = entry[p].inverse();
+    }
+    for (int i = 0; i < n - 1; i++) {
+        for (int p = 0; p < 26; p++) {
+            inner.push_back(machine.rotor(i).permutation(p));
+            inner_inverse.push_back(inner.back().inverse());
+        }
+    }
+
+    for (long i = 0; i < length; i++) {
+        machine.seek(1);
+        machine.getPositions(positions.data());
+
+        if (composed.empty() ||
+            !equal(positions.begin(), positions.end() - 1, composed.begin())) {
+            core = machine.reflector();
+            for (int j = 0; j < n - 1; j++) {
+                int at = 26 * j + positions[j];
+                core = inner[at].then(core).then(inner_inverse[at]);
+            }
+            composed = positions;
+        } // Only when a rotor other than the rightmost has moved
+
+        int p = positions[n - 1];
+        output[i] = exit[p][core[entry[p][input[i] - 'A']]] + 'A';
+    }
+}
+
+
+static void keystreamEngine
+(Enigma<>& machine, char const input[], char output[], long length)
+{
+    Keystream<> stream(machine);
+    Permutation steps[KEYSTREAM_BLOCK];
+
+    for (long i = 0; i < length; i += KEYSTREAM_BLOCK) {
+        long n = min<long>(KEYSTREAM_BLOCK, length - i);
+        stream.fill(steps, n);
+        for (long j = 0; j < n; j++)
+            output[i + j] = steps[j][input[i + j] - 'A'] + 'A';
+    }
+
+    machine.seek(length);
+}
+
+
+static void advance(Enigma<>& machine, long presses)
+{
+    int n = machine.rotorCount();
+    vector<int> positions(n);
+
+    machine.getPositions(positions.data());
+    for (int i = n - 1; i >= 0 && presses > 0; i--) {
+        Rotor notches(machine.rotor(i));
+        long carries = 0;
+        for (int p = 0; p < 26; p++) {
+            notches.setPosition(p);
+            if (!notches.atNotch())
+                continue;
+            int first = (p - positions[i] + 25) % 26 + 1; // Presses to reach
+            carries += presses / 26 + (first <= presses % 26 ? 1 : 0);
+        } // Turned 'presses' times, the rotor lands on p once per full turn,
+          // and once more if p is within the part turn left over
+
+        positions[i] = (positions[i] + presses) % 26;
+        presses = carries; // Each landing on a notch turns the next rotor
+    }
+    machine.setPositions(positions.data());
+}
+
+
+static void substitutionEngine
+(Enigma<>& machine, char const input[], char output[], long length)
+{
+    machine.permutation().substitute(input, output, length);
+    advance(machine, length); // In place of seek, which turns the rotors
+                              // once per letter
+}
+
+
+static bool fixedSubstitution(Enigma<> const& machine)
+{
+    for (int i = 0; i < machine.rotorCount(); i++) {
+        Permutation first = machine.rotor(i).permutation(0);
+        for (int p = 1; p < 26; p++) {
+            if (machine.rotor(i).permutation(p) != first)
+                return false;
+        }
+    }
+
+    return true;
+} // Rotors still turn, but a rotor which maps the same way at every
+  // position, such as a pure shift, never changes the substitution
+
+
+static Engine const ENGINES[] = {
+    {"reference", referenceEngine, nullptr},
+    {"core", coreEngine, nullptr},
+    {"keystream", keystreamEngine, nullptr},
+    {"substitution", substitutionEngine, fixedSubstitution}
+}; // The reference must stay first
+
+
+int noOfEngines()
+{
+    return sizeof(ENGINES) / sizeof(ENGINES[0]);
+}
+
+
+Engine const& engine(int index)
+{
+    return ENGINES[index];
+}
+
+
+int engineIndex(string const& name)
+{
+    for (int i = 0; i < noOfEngines(); i++) {
+        if (name == ENGINES[i].name)
+            return i;
+    }
+
+    return -1;
+}
+
+
+EngineSelector::EngineSelector(int forced)
+    : forced_(forced)
+{
+}
+
+
+int EngineSelector::choose(Enigma<> const& machine, long workload)
+{
+    int bits = 0;
+
+    while ((workload >> bits) > 1)
+        bits++;
+    unsigned usable = 0;
+    for (int i = 0; i < noOfEngines(); i++) {
+        if (!engine(i).usable || engine(i).usable(machine))
+            usable |= 1u << i;
+    }
+    Shape shape(machine.rotorCount(), bits, usable);
+
+    unique_lock<mutex> hold(lock_);
+    auto found = choices_.find(shape);
+    if (found == choices_.end()) {
+        found = choices_.insert(make_pair(shape, Choice())).first;
+        found->second.ready = false;
+        hold.unlock();
+        // Other shapes are chosen meanwhile; this one waits below
+
+        Choice choice;
+        calibrate(machine, workload, choice);
+        choice.ready = true;
+
+        hold.lock();
+        found->second = choice;
+        cerr << "Chose engine '" << engine(choice.engine).name << "' for ";
+        cerr << get<0>(shape) << " rotors and about " << (1L << bits);
+        cerr << " letters.\n";
+        calibrated_.notify_all();
+    }
+    calibrated_.wait(hold, [&] { return found->second.ready; });
+    found->second.jobs++;
+    found->second.letters += workload;
+
+    return found->second.engine;
+}
+
+
+void EngineSelector::encrypt
+(Enigma<>& machine, char const input[], char output[], long length, int& err)
+{
+    long valid = 0;
+
+    while (valid < length && input[valid] >= 'A' && input[valid] <= 'Z')
+        valid++;
+
+    engine(choose(machine, valid)).run(machine, input, output, valid);
+
+    if (valid < length)
+        machine.encrypt(input + valid, output + valid, 1, err);
+    // Stops at the bad character with the reference's message, before
+    // turning the rotors
+}
+
+
+void EngineSelector::report(ostream& outs) const
+{
+    lock_guard<mutex> hold(lock_);
+
+    for (auto const& entry : choices_) {
+        Choice const& choice = entry.second;
+        if (!choice.ready)
+            continue;
+        outs << "Engine '" << engine(choice.engine).name << "' for ";
+        outs << get<0>(entry.first) << " rotors and about ";
+        outs << (1L << get<1>(entry.first)) << " letters: " << choice.jobs;
+        outs << " jobs, " << choice.letters << " letters.";
+        if (forced_ < 0)
+            outs << " Calibrated, in ns per letter:";
+        for (int i = 0; i < noOfEngines(); i++) {
+            if (choice.ns_per_letter[i] >= 0)
+                outs << ' ' << engine(i).name << ' '
+                     << choice.ns_per_letter[i];
+        }
+        outs << '\n';
+    }
+}
+
+
+void EngineSelector::calibrate
+(Enigma<> const& machine, long workload, Choice& choice)
+{
+    long length = max(MIN_PROBE, min(MAX_PROBE, workload));
+    vector<char> probe(length), expected(length), output(length);
+    int n = machine.rotorCount();
+    vector<int> expected_positions(n), positions(n);
+    unsigned seed = 12345;
+
+    for (char& ch : probe) {
+        seed = seed * 1103515245 + 12345;
+        ch = 'A' + (seed >> 16) % 26;
+    }
+
+    Enigma<> reference(machine);
+    engine(0).run(reference, probe.data(), expected.data(), length);
+    reference.getPositions(expected_positions.data());
+
+    choice.jobs = choice.letters = 0;
+    choice.engine = forced_ >= 0 ? forced_ : 0;
+    for (int i = 0; i < MAX_ENGINES; i++)
+        choice.ns_per_letter[i] = -1;
+    if (forced_ >= 0) {
+        Engine const& forced = engine(forced_);
+        if (forced.usable && !forced.usable(machine)) {
+            cerr << "Engine '" << forced.name << "' cannot encrypt for this ";
+            cerr << "machine, so the reference will be used.\n";
+            choice.engine = 0;
+            return;
+        }
+
+        Enigma<> copy(machine);
+        forced.run(copy, probe.data(), output.data(), length);
+        copy.getPositions(positions.data());
+        if (output != expected || positions != expected_positions) {
+            cerr << "Engine '" << forced.name << "' disagrees with the ";
+            cerr << "reference, so the reference will be used.\n";
+            choice.engine = 0;
+        }
+        return;
+    }
+
+    for (int i = 0; i < noOfEngines(); i++) {
+        Engine const& candidate = engine(i);
+        if (candidate.usable && !candidate.usable(machine))
+            continue;
+
+        double best = 0;
+        bool agrees = true;
+        for (int run = 0; run < CALIBRATION_RUNS && agrees; run++) {
+            Enigma<> copy(machine);
+            auto start = chrono::steady_clock::now();
+            candidate.run(copy, probe.data(), output.data(), length);
+            chrono::duration<double, nano> taken =
+                chrono::steady_clock::now() - start;
+
+            copy.getPositions(positions.data());
+            agrees = output == expected && positions == expected_positions;
+            if (run == 0 || taken.count() < best)
+                best = taken.count();
+        }
+
+        if (!agrees) {
+            cerr << "Engine '" << candidate.name << "' disagrees with the ";
+            cerr << "reference, so will not be used.\n";
+            continue;
+        }
+        choice.ns_per_letter[i] = best / length;
+        if (choice.ns_per_letter[i] < choice.ns_per_letter[choice.engine])
+            choice.engine = i;
+    }
+}
@@ -0,0 +1,115 @@
+/* Encryption engine header file
+ *
+ * This file contains the header file for the encryption engines, and the
+ * selector which picks the fastest correct one for each machine shape.
+ */
+
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include "enigma.h"
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <tuple>
+
+int const MAX_ENGINES = 8;
+long const MIN_PROBE = 64; // Letters each engine is timed on, at least
+long const MAX_PROBE = 4096; // and at most
+
+
+/* An engine encrypts a buffer of letters A - Z exactly as Enigma::encrypt
+   would, leaving the machine where Enigma::encrypt would. Engines other
+   than the reference only differ in how they get there. */
+typedef void (*EngineFunction)
+    (Enigma<>& machine, char const input[], char output[], long length);
+
+struct Engine {
+    char const* name;
+    EngineFunction run;
+    bool (*usable)(Enigma<> const& machine); // Null if always usable
+};
+
+
+int noOfEngines();
+/* Postcondition:
+   The number of engines is returned. Engine 0 is the reference. */
+
+Engine const& engine(int index);
+/* Precondition:
+   'index' is between 0 and noOfEngines() - 1. */
+/* Postcondition:
+   The engine is returned. */
+
+int engineIndex(std::string const& name);
+/* Postcondition:
+   The index of the engine called 'name' is returned, or -1 if there is
+   none. */
+
+
+/* The 'EngineSelector' class encrypts with whichever engine is fastest for
+   the shape of the job: the number of rotors, the size of the workload,
+   rounded to a power of two, and which engines are usable for the machine.
+   The first time a shape is seen, every usable engine is run on a probe
+   text from a copy of the machine, its output and final positions checked
+   against the reference, and timed. The fastest engine which agreed is
+   kept for the shape and logged. One selector may be shared by any number
+   of threads; one of them calibrates each new shape, without holding up
+   the others, while those needing the same shape wait for it. */
+class EngineSelector {
+ public:
+    EngineSelector(int forced = -1);
+    /* Postcondition:
+       If 'forced' is an engine index, that engine is always used, without
+       timing, once it has agreed with the reference on the probe text;
+       otherwise engines are chosen as above. */
+
+    int choose(Enigma<> const& machine, long workload);
+    /* Precondition:
+       'machine' is configured. */
+    /* Postcondition:
+       The index of the engine for jobs of 'workload' letters on machines
+       shaped like 'machine' is returned, calibrating first if need be. */
+
+    void encrypt
+        (Enigma<>& machine, char const input[], char output[], long length,
+         int& err);
+    /* Precondition:
+       As for Enigma::encrypt. */
+    /* Postcondition:
+       As for Enigma::encrypt, using the chosen engine. */
+
+    void report(std::ostream& outs) const;
+    /* Postcondition:
+       The engine chosen for each shape seen, the timings it was chosen on,
+       and the jobs and letters it has encrypted are written to 'outs'. */
+
+ private:
+    typedef std::tuple<int, int, unsigned> Shape;
+    // Rotors, bit length of workload, and a bit for each usable engine
+
+    struct Choice {
+        int engine;
+        double ns_per_letter[MAX_ENGINES]; // Negative if unusable or wrong
+        long jobs;
+        long letters;
+        bool ready; // False while a thread calibrates it
+    };
+
+    int forced_;
+    mutable std::mutex lock_;
+    std::condition_variable calibrated_;
+    std::map<Shape, Choice> choices_;
+
+    void calibrate(Enigma<> const& machine, long workload, Choice& choice);
+    /* Postcondition:
+       Every usable engine, or only the forced one, is checked and timed on
+       a probe text of 'workload' letters, clamped to MIN_PROBE -
+       MAX_PROBE, and 'choice' holds the result. Only 'forced_' is shared,
+       so it is called without holding 'lock_'. */
+};
+
+
+#endif
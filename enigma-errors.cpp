@@ -16,7 +16,8 @@
 using namespace std;
 
 
-int Enigma::invalidNoOfReflections
+template <class Stepping>
+int Enigma<Stepping>::invalidNoOfReflections
 (int no_of_reflections, char const filename[]) const
 {
     if (no_of_reflections != 26) { // 26 mappings required
@@ -30,7 +31,8 @@ int Enigma::invalidNoOfReflections
 }
 
 
-int Enigma::invalidNoOfPlugs
+template <class Stepping>
+int Enigma<Stepping>::invalidNoOfPlugs
 (int no_of_plugs, char const filename[]) const
 {
     if (no_of_plugs % 2) { // must be even
@@ -45,7 +47,8 @@ int Enigma::invalidNoOfPlugs
 }
 
 
-bool Enigma::idempotentMapping
+template <class Stepping>
+bool Enigma<Stepping>::idempotentMapping
 (int pair[], int i, ifstream& input, char const filename[]) const
 {
     if (i % 2) {
@@ -64,7 +67,8 @@ bool Enigma::idempotentMapping
 }  
 
 
-int Enigma::invalidReflection
+template <class Stepping>
+int Enigma<Stepping>::invalidReflection
 (int pair[], int i, ifstream& input, char const filename[]) const
 {
     if (i >= 26) // First checks if loop index out of bounds
@@ -94,7 +98,8 @@ int Enigma::invalidReflection
 }
 
 
-int Enigma::invalidPlug
+template <class Stepping>
+int Enigma<Stepping>::invalidPlug
 (int pair[], int i, ifstream& input, char const filename[]) const
 {
     if (i >= 26) // First check if loop index out of bounds
@@ -123,7 +128,8 @@ int Enigma::invalidPlug
 }
 
 
-int Enigma::invalidInput(char ch) const
+template <class Stepping>
+int Enigma<Stepping>::invalidInput(char ch) const
 {
     if (ch < 'A' || ch > 'Z') {
         cerr << "\n'" << ch << "' is not a valid input character.\n";
@@ -135,7 +141,8 @@ int Enigma::invalidInput(char ch) const
 }
 
 
-int Enigma::invalidParams(int argc) const
+template <class Stepping>
+int Enigma<Stepping>::invalidParams(int argc) const
 {
     if (argc < 3) {
         cerr << "Too few command line parameters given.\n";
@@ -148,3 +155,27 @@ int Enigma::invalidParams(int argc) const
 
     return NO_ERROR;
 }
+
+
+/* The class itself is instantiated in enigma.cpp, which only instantiates
+   the members defined there, so the ones defined here are instantiated one
+   by one. */
+#define INSTANTIATE_ERROR_CHECKS(Stepping)                                 \
+    template int Enigma<Stepping>::invalidNoOfReflections                 \
+        (int, char const[]) const;                                         \
+    template int Enigma<Stepping>::invalidNoOfPlugs                       \
+        (int, char const[]) const;                                         \
+    template bool Enigma<Stepping>::idempotentMapping                     \
+        (int[], int, ifstream&, char const[]) const;                       \
+    template int Enigma<Stepping>::invalidReflection                      \
+        (int[], int, ifstream&, char const[]) const;                       \
+    template int Enigma<Stepping>::invalidPlug                            \
+        (int[], int, ifstream&, char const[]) const;                       \
+    template int Enigma<Stepping>::invalidInput(char) const;              \
+    template int Enigma<Stepping>::invalidParams(int) const;
+
+INSTANTIATE_ERROR_CHECKS(OdometerStepping)
+INSTANTIATE_ERROR_CHECKS(DoubleStepping)
+INSTANTIATE_ERROR_CHECKS(CogwheelStepping)
+
+#undef INSTANTIATE_ERROR_CHECKS
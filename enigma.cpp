@@ -14,7 +14,8 @@
 using namespace std;
 
 
-Enigma::Enigma(int no_of_rotors)
+template <class Stepping>
+Enigma<Stepping>::Enigma(int no_of_rotors)
 {
     for (int i = 0; i < 26; i++) {
         plugboard_[i] = -1;
@@ -22,7 +23,8 @@ Enigma::Enigma(int no_of_rotors)
     }
     // Default set to -1 to prevent overlapping maps during setConfig
     
-    no_of_rotors_ = no_of_rotors;
+    no_of_rotors_ = (no_of_rotors > 0) ? no_of_rotors : 0;
+    // main passes (argc - 4), which is -1 for a machine with no rotors
     
     if (no_of_rotors > 0)
         rotors_ = new Rotor[no_of_rotors];
@@ -31,7 +33,8 @@ Enigma::Enigma(int no_of_rotors)
 }
 
 
-Enigma::Enigma(Enigma const& enigma)
+template <class Stepping>
+Enigma<Stepping>::Enigma(Enigma const& enigma)
 {
     for (int i = 0; i < 26; i++) {
         plugboard_[i] = enigma.plugboard_[i];
@@ -49,14 +52,16 @@ Enigma::Enigma(Enigma const& enigma)
 }
 
 
-Enigma::~Enigma()
+template <class Stepping>
+Enigma<Stepping>::~Enigma()
 {
     if (no_of_rotors_ > 0)
         delete [] rotors_;
 }
 
 
-void Enigma::setRotors(int argc, char** argv, int& err)
+template <class Stepping>
+void Enigma<Stepping>::setRotors(int argc, char** argv, int& err)
 {
     ifstream rot_file;
     ifstream pos_file(argv[argc-1]);
@@ -84,7 +89,8 @@ void Enigma::setRotors(int argc, char** argv, int& err)
 }
 
 
-void Enigma::setReflector(char const filename[], int& err)
+template <class Stepping>
+void Enigma<Stepping>::setReflector(char const filename[], int& err)
 {    
     int i;
     int pair[2]; // Stores the pair of values to be mapped to each other
@@ -114,7 +120,8 @@ void Enigma::setReflector(char const filename[], int& err)
 }
 
 
-void Enigma::setPlugboard(char const filename[], int& err)
+template <class Stepping>
+void Enigma<Stepping>::setPlugboard(char const filename[], int& err)
 {
     int i;
     int pair[2]; // Stores the pair of values to be mapped to each other
@@ -146,7 +153,8 @@ void Enigma::setPlugboard(char const filename[], int& err)
 }    
 
 
-void Enigma::setRemainingPlugs()
+template <class Stepping>
+void Enigma<Stepping>::setRemainingPlugs()
 {
     for (int i = 0; i < 26; i++) {
         if (plugboard_[i] == -1)
@@ -155,7 +163,8 @@ void Enigma::setRemainingPlugs()
 }    
 
 
-int Enigma::keyPress(int key)
+template <class Stepping>
+int Enigma<Stepping>::keyPress(int key)
 {    
     turnRotors();    
     
@@ -175,17 +184,115 @@ int Enigma::keyPress(int key)
 }
 
 
-void Enigma::turnRotors()
+template <class Stepping>
+void Enigma<Stepping>::turnRotors()
 {
-    int i = no_of_rotors_ - 1;
+    Stepping::turn(rotors_, no_of_rotors_);
+}
+
 
-    while (i >= 0 && rotors_[i].turn()) 
-        i--;
-    // (i >= 0) checked first, since rotors_[i] may not exist
+template <class Stepping>
+void Enigma<Stepping>::seek(long presses)
+{
+    for (; presses > 0; presses--)
+        turnRotors();
 }
     
 
-void Enigma::encrypt(istream& ins, ostream& outs, int& err)
+template <class Stepping>
+void Enigma<Stepping>::setPositions(int const positions[])
+{
+    for (int i = 0; i < no_of_rotors_; i++)
+        rotors_[i].setPosition(positions[i]);
+}
+
+
+template <class Stepping>
+void Enigma<Stepping>::getPositions(int positions[]) const
+{
+    for (int i = 0; i < no_of_rotors_; i++)
+        positions[i] = rotors_[i].position();
+}
+
+
+template <class Stepping>
+int Enigma<Stepping>::rotorCount() const
+{
+    return no_of_rotors_;
+}
+
+
+template <class Stepping>
+unsigned long Enigma<Stepping>::configHash() const
+{
+    unsigned long hash = 14695981039346656037UL; // FNV-1a
+    auto add = [&hash](int value) {
+        hash = (hash ^ (unsigned long) value) * 1099511628211UL;
+    };
+
+    add(no_of_rotors_);
+    for (int i = 0; i < 26; i++) {
+        add(plugboard_[i]);
+        add(reflector_[i]);
+    }
+    for (int r = 0; r < no_of_rotors_; r++) {
+        Rotor rotor(rotors_[r]);
+        Permutation wiring = rotor.permutation(0);
+        for (int i = 0; i < 26; i++) {
+            rotor.setPosition(i);
+            add(wiring[i]);
+            add(rotor.atNotch());
+        }
+    }
+
+    return hash;
+}
+
+
+template <class Stepping>
+Permutation Enigma<Stepping>::permutation() const
+{
+    Permutation half(plugboard_);
+
+    for (int i = (no_of_rotors_ - 1); i >= 0; i--)
+        half = half.then(rotors_[i].permutation());
+    // Left to right through the rotors and plugboard is the inverse of
+    // right to left, so only one half of the path needs composing
+
+    return half.then(Permutation(reflector_)).then(half.inverse());
+}
+
+
+template <class Stepping>
+Permutation Enigma<Stepping>::plugboard() const
+{
+    return Permutation(plugboard_);
+}
+
+
+template <class Stepping>
+Permutation Enigma<Stepping>::reflector() const
+{
+    return Permutation(reflector_);
+}
+
+
+template <class Stepping>
+Rotor const& Enigma<Stepping>::rotor(int i) const
+{
+    return rotors_[i];
+}
+
+
+template <class Stepping>
+void Enigma<Stepping>::setRotor(int i, Rotor const& rotor)
+{
+    rotors_[i] = rotor;
+}
+
+
+template <class Stepping>
+void Enigma<Stepping>::encrypt(istream& ins, ostream& outs, int& err)
 {
     char ch, output;
     
@@ -205,7 +312,21 @@ void Enigma::encrypt(istream& ins, ostream& outs, int& err)
 }
 
 
-void Enigma::setConfig(int argc, char** argv, int& err)
+template <class Stepping>
+void Enigma<Stepping>::encrypt
+(char const input[], char output[], long length, int& err)
+{
+    for (long i = 0; i < length; i++) {
+        if ( (err = invalidInput(input[i])) )
+            return;
+        
+        output[i] = keyPress(input[i] - 'A') + 'A';
+    }
+}
+
+
+template <class Stepping>
+void Enigma<Stepping>::setConfig(int argc, char** argv, int& err)
 {
     if ( (err = invalidParams(argc)) )
         return;
@@ -224,3 +345,8 @@ void Enigma::setConfig(int argc, char** argv, int& err)
             return;
     }
 }
+
+
+template class Enigma<OdometerStepping>;
+template class Enigma<DoubleStepping>;
+template class Enigma<CogwheelStepping>;
@@ -3,20 +3,25 @@
  * Author: Philip Cai 
  * Last modified: 19/11/2018
  * 
- * This file contains the enigma class header file.
+ * This file contains the enigma class header file. The class is a template
+ * over the rotor stepping policy (see stepping.h); the policies in use are
+ * explicitly instantiated at the bottom of enigma.cpp and enigma-errors.cpp.
  */
 
 #ifndef ENIGMA_H
 #define ENIGMA_H
 
 #include "rotor.h"
+#include "stepping.h"
 #include <fstream>
 
 
 /* The 'Enigma' class consists of the plugboard and reflector mappings,
    number of rotors, and the rotors themselves. The machine parameters
    can be configured via config files, and messages can be sent in to
-   be encrypted. */
+   be encrypted. The 'Stepping' policy decides how the rotors turn on each
+   key press. */
+template <class Stepping = OdometerStepping>
 class Enigma {
  public:
     Enigma(int no_of_rotors); // Constructor
@@ -42,6 +47,75 @@ class Enigma {
        If an error is encountered, the function immediately returns with the
        error code changed. Otherwise, the data fed through ins is encrypted 
        and sent to outs, and err = 0. */
+
+    void encrypt(char const input[], char output[], long length, int& err);
+    /* Precondition:
+       'input' holds 'length' characters, 'output' has space for as many,
+       and 'err' is the error code, currently set to 0. */
+    /* Postcondition:
+       If a character is not an upper case letter, the function returns
+       with the error code changed. Otherwise, every character is encrypted
+       into 'output', and err = 0. */
+
+    void seek(long presses);
+    /* Precondition:
+       The machine is configured, and 'presses' is not negative. */
+    /* Postcondition:
+       The rotors are in the positions they would reach after 'presses' key
+       presses under the machine's stepping policy. */
+
+    void setPositions(int const positions[]);
+    /* Precondition:
+       'positions' holds one integer between 0 and 25 for each rotor, given
+       left to right as in a .pos file. */
+    /* Postcondition:
+       The rotors are set to the given positions. */
+
+    void getPositions(int positions[]) const;
+    /* Precondition:
+       'positions' has space for one integer per rotor. */
+    /* Postcondition:
+       'positions' holds the current rotor positions, left to right. */
+
+    int rotorCount() const;
+    /* Postcondition:
+       The number of rotors is returned. */
+
+    unsigned long configHash() const;
+    /* Precondition:
+       The machine is configured. */
+    /* Postcondition:
+       A hash of the plugboard, reflector, and each rotor's wiring and
+       notches is returned. Machines which differ only in their rotor
+       positions have the same hash. */
+
+    Permutation permutation() const;
+    /* Precondition:
+       The machine is configured. */
+    /* Postcondition:
+       The permutation the whole machine applies at the current rotor
+       positions is returned. A key press turns the rotors first, so the
+       next key press applies the permutation after 'seek(1)'. */
+
+    Permutation plugboard() const;
+    Permutation reflector() const;
+    /* Precondition:
+       The machine is configured. */
+    /* Postcondition:
+       The plugboard or reflector mapping is returned. */
+
+    Rotor const& rotor(int i) const;
+    /* Precondition:
+       'i' is the index of a rotor, counting from the left. */
+    /* Postcondition:
+       The rotor is returned. */
+
+    void setRotor(int i, Rotor const& rotor);
+    /* Precondition:
+       'i' is the index of a rotor, counting from the left, and 'rotor' has
+       its mappings and notches set. */
+    /* Postcondition:
+       Rotor 'i' is replaced by a copy of 'rotor'. */
     
  private:
     int plugboard_[26]; // (plugboard_[x] = y) means "x is mapped to y".
@@ -53,16 +127,16 @@ class Enigma {
     /* Precondition: 
        'key' is an integer between 0 and 25, and all the mappings are set. */
     /* Postcondition: 
-       The rightmost rotor is turned one tick, and all the others turn 
-       accordingly. The integer returned is the ciphered letter corresponding
+       The rotors are turned by one key press according to the stepping
+       policy. The integer returned is the ciphered letter corresponding
        to the input letter. */
     
     void turnRotors();
     /* Precondition: 
        The rotors have been declared. */
     /* Postcondition: 
-       The rightmost rotor is turned one tick, and all others turn according
-       to the notch positions of the rotor to their left. */
+       The rotors are turned by one key press according to the stepping
+       policy. */
     
     void setPlugboard(char const filename[], int& err);
     /* Precondition: 
@@ -165,4 +239,10 @@ class Enigma {
 };
 
 
+extern template class Enigma<OdometerStepping>;
+extern template class Enigma<DoubleStepping>;
+extern template class Enigma<CogwheelStepping>;
+// Instantiated once, in enigma.cpp and enigma-errors.cpp
+
+
 #endif
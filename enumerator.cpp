@@ -0,0 +1,118 @@
+/* Key enumerator member functions
+ *
+ * This file contains the definitions for member functions to walk the rotor
+ * start positions while keeping the machine permutation up to date.
+ */
+
+#include "enumerator.h"
+#include "permutation.h"
+#include <vector>
+
+using namespace std;
+
+
+void rotorOrders(int library_size, int per_order, vector<int>& orders)
+{
+    int limit[3] = {1, 1, 1};
+
+    for (int i = 0; i < per_order; i++)
+        limit[i] = library_size;
+
+    orders.clear();
+    for (int a = 0; a < limit[0]; a++) {
+        for (int b = 0; b < limit[1]; b++) {
+            for (int c = 0; c < limit[2]; c++) {
+                if ((per_order < 2 || a != b) &&
+                    (per_order < 3 || (b != c && a != c))) {
+                    int order[3] = {a, b, c};
+                    orders.insert(orders.end(), order, order + per_order);
+                }
+            }
+        }
+    }
+}
+
+
+void KeyEnumerator::init(Permutation const& reflector)
+{
+    size_ = 1;
+    for (int i = 0; i < no_of_rotors_; i++)
+        size_ *= 26;
+
+    for (Permutation const& perm : rotor_perms_)
+        rotor_invs_.push_back(perm.inverse());
+
+    if (no_of_rotors_ > 0) {
+        int right = 26 * (no_of_rotors_ - 1);
+        for (int p = 0; p < 26; p++) {
+            entry_[p] = plugboard_.then(rotor_perms_[right + p]);
+            exit_[p] = rotor_invs_[right + p].then(plugboard_);
+        }
+        // The plugboard is folded into the rightmost rotor, which moves
+        // on every key
+    }
+
+    cores_.assign(no_of_rotors_ > 0 ? no_of_rotors_ : 1, reflector);
+    positions_.assign(no_of_rotors_, 0);
+    seek(0);
+}
+
+
+long KeyEnumerator::size() const
+{
+    return size_;
+}
+
+
+KeyRange KeyEnumerator::block(int part, int parts) const
+{
+    KeyRange range;
+
+    range.first = size_ / parts * part + min<long>(part, size_ % parts);
+    range.last = range.first + size_ / parts + (part < size_ % parts);
+    // The first (size_ % parts) blocks take one spare key each
+
+    return range;
+}
+
+
+void KeyEnumerator::seek(long key)
+{
+    key_ = key;
+
+    for (int i = no_of_rotors_ - 1; i >= 0; i--, key /= 26)
+        positions_[i] = key % 26;
+    // Rightmost rotor is the lowest digit of the key
+
+    compose(0);
+}
+
+
+void KeyEnumerator::carry()
+{
+    int i = no_of_rotors_ - 1;
+
+    while (i > 0 && positions_[i] == 26) {
+        positions_[i] = 0;
+        positions_[--i]++;
+    }
+    if (i == 0 && positions_[0] == 26)
+        positions_[0] = 0; // Wrapped round past the last key
+
+    compose(i > 0 ? i : 0);
+}
+
+
+void KeyEnumerator::compose(int from)
+{
+    for (int i = from; i < no_of_rotors_ - 1; i++) {
+        int at = 26 * i + positions_[i];
+        cores_[i + 1] = rotor_perms_[at].then(cores_[i]).then(rotor_invs_[at]);
+    }
+
+    if (no_of_rotors_ > 0) {
+        int p = positions_[no_of_rotors_ - 1];
+        permutation_ = entry_[p].then(cores_[no_of_rotors_ - 1]).then(exit_[p]);
+    } else
+        permutation_ = plugboard_.then(cores_[0]).then(plugboard_);
+}
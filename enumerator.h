@@ -0,0 +1,144 @@
+/* Key enumerator class header file
+ *
+ * This file contains the header file for the key enumerator class, which
+ * walks the rotor start positions of a configured machine.
+ */
+
+#ifndef ENUMERATOR_H
+#define ENUMERATOR_H
+
+#include "enigma.h"
+#include "permutation.h"
+#include <vector>
+
+
+/* 'KeyRange' is the block of keys [first, last). */
+struct KeyRange {
+    long first;
+    long last;
+};
+
+
+void rotorOrders(int library_size, int per_order, std::vector<int>& orders);
+/* Precondition:
+   'per_order' is 1, 2 or 3. */
+/* Postcondition:
+   'orders' holds, 'per_order' library indices at a time, every ordered
+   choice of distinct rotors from a library of 'library_size', in
+   lexicographic order. */
+
+
+/* The 'KeyEnumerator' class walks every rotor start position of a machine in
+   odometer order, so that successive keys differ only in the rightmost rotor
+   except when it wraps. A key is the start positions read as a base 26
+   number, leftmost rotor first. Alongside each key the enumerator keeps the
+   machine permutation at those positions. The part of the signal path
+   inside each rotor is kept for every rotor, so moving the rightmost rotor
+   costs two shuffles and a carry only recomposes the rotors it moved.
+   Each thread should use its own copy on its own block of keys. */
+class KeyEnumerator {
+ public:
+    template <class Stepping>
+    KeyEnumerator(Enigma<Stepping> const& enigma); // Constructor
+
+    long size() const;
+    /* Postcondition:
+       The number of keys, 26 to the power of the number of rotors, is
+       returned. */
+
+    KeyRange block(int part, int parts) const;
+    /* Precondition:
+       'part' is an integer between 0 and parts - 1. */
+    /* Postcondition:
+       The 'part'th of 'parts' contiguous blocks covering every key is
+       returned. The blocks differ in size by at most one key. */
+
+    void seek(long key);
+    /* Precondition:
+       'key' is between 0 and size() - 1. */
+    /* Postcondition:
+       The enumerator is set to 'key', and every cached permutation is
+       recomposed. */
+
+    void next()
+    {
+        key_++;
+        if (no_of_rotors_ && ++positions_[no_of_rotors_ - 1] < 26)
+            permutation_ = entry_[positions_[no_of_rotors_ - 1]]
+                .then(cores_[no_of_rotors_ - 1])
+                .then(exit_[positions_[no_of_rotors_ - 1]]);
+        else
+            carry();
+    }
+    /* Precondition:
+       The enumerator has been set with 'seek'. */
+    /* Postcondition:
+       The enumerator moves on to the next key. Past the last key, the key
+       is size() and the positions wrap round to 0. */
+
+    long key() const
+    { return key_; }
+
+    int const* positions() const
+    { return positions_.data(); }
+    /* Postcondition:
+       The start positions of the current key are returned, left to right,
+       ready for Enigma::setPositions. */
+
+    Permutation const& permutation() const
+    { return permutation_; }
+    /* Postcondition:
+       The machine permutation at the current positions is returned. It
+       equals Enigma::permutation() with the rotors at positions(). */
+
+ private:
+    int no_of_rotors_;
+    long size_;
+    long key_;
+    std::vector<int> positions_;
+    std::vector<Permutation> rotor_perms_; // [26 * i + p]: rotor i at p
+    std::vector<Permutation> rotor_invs_; // Inverses of the above
+    std::vector<Permutation> cores_;
+    // cores_[0] is the reflector, and cores_[i] the path from entering
+    // rotor i - 1 right to left, via the reflector, to leaving it again
+    Permutation entry_[26]; // Plugboard then rightmost rotor at position p
+    Permutation exit_[26]; // The reverse of 'entry_'
+    Permutation permutation_;
+    Permutation plugboard_;
+
+    void init(Permutation const& reflector);
+    /* Precondition:
+       'no_of_rotors_', 'plugboard_' and 'rotor_perms_' are set. */
+    /* Postcondition:
+       The remaining tables are set, and the enumerator is at key 0. */
+
+    void carry();
+    /* Postcondition:
+       The positions are moved on one key with carries, and the cores of
+       every rotor which moved are recomposed. */
+
+    void compose(int from);
+    /* Precondition:
+       'cores_' are up to date for every rotor left of rotor 'from'. */
+    /* Postcondition:
+       'cores_' and 'permutation_' are recomposed from rotor 'from' onwards
+       for the current positions. */
+};
+
+
+template <class Stepping>
+KeyEnumerator::KeyEnumerator(Enigma<Stepping> const& enigma)
+{
+    no_of_rotors_ = enigma.rotorCount();
+    plugboard_ = enigma.plugboard();
+
+    for (int i = 0; i < no_of_rotors_; i++) {
+        for (int p = 0; p < 26; p++)
+            rotor_perms_.push_back(enigma.rotor(i).permutation(p));
+    }
+
+    init(enigma.reflector());
+}
+
+
+#endif
@@ -0,0 +1,109 @@
+/* Workload generator program
+ *
+ * This file contains the main program for generating key sheets and
+ * plaintext corpora for load and soak testing. Usage:
+ * './generate [-s <seed>] [-n <sheets>] [-r <rotors>] [-c <corpus size>]
+ *  [-x] <directory>'
+ * Writes 'n' key sheets of 'r' rotors each (one of three by default) into
+ * the directory, with sheets.txt listing their command lines, and with '-c'
+ * a corpus.txt of the given size, which may end in K, M or G. '-x' also
+ * writes broken files for every error code, listed in invalid/cases.txt.
+ * The same seed always gives the same files. */
+
+#include "errors.h"
+#include "generate.h"
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <sys/stat.h>
+
+using namespace std;
+
+
+long parseSize(char const text[])
+{
+    char* end;
+    long size = strtol(text, &end, 10);
+    int shift = 0;
+
+    switch (*end) {
+    case 'G': case 'g':
+        shift += 10; // Falls through
+    case 'M': case 'm':
+        shift += 10; // Falls through
+    case 'K': case 'k':
+        shift += 10;
+        end++;
+    }
+
+    if (end == text || *end || size < 0 || size > (LONG_MAX >> shift))
+        return -1;
+    return size << shift;
+}
+
+
+int main(int argc, char** argv)
+{
+    unsigned long seed = 1;
+    int sheets = 1, depth = 3, err = NO_ERROR;
+    long corpus = 0;
+    bool invalid = false;
+    int arg = 1;
+
+    for (; arg < argc && argv[arg][0] == '-'; arg++) {
+        string option = argv[arg];
+        if (option == "-x")
+            invalid = true;
+        else if (arg + 1 < argc && option == "-s")
+            seed = strtoul(argv[++arg], nullptr, 10);
+        else if (arg + 1 < argc && option == "-n")
+            sheets = atoi(argv[++arg]);
+        else if (arg + 1 < argc && option == "-r")
+            depth = atoi(argv[++arg]);
+        else if (arg + 1 < argc && option == "-c")
+            corpus = parseSize(argv[++arg]);
+        else
+            break;
+    }
+
+    if (arg + 1 != argc || sheets < 0 || depth < 1 || corpus < 0 ||
+        corpus == 1) {
+        cerr << "Too few command line parameters given, or invalid ones.\n";
+        cerr << "'./generate [-s <seed>] [-n <sheets>] [-r <rotors>] ";
+        cerr << "[-c <corpus size>] [-x] <directory>'\n\n";
+        return INSUFFICIENT_NUMBER_OF_PARAMETERS;
+    }
+
+    string directory = argv[arg];
+    if (mkdir(directory.c_str(), 0755) && errno != EEXIST) {
+        cerr << "Error opening '" << directory << "'.\n";
+        return ERROR_OPENING_CONFIGURATION_FILE;
+    }
+
+    auto start = chrono::steady_clock::now();
+    int files = generateSheets(directory, seed, sheets, depth, invalid, err);
+    chrono::duration<double> taken = chrono::steady_clock::now() - start;
+    if (err) {
+        cerr << "Error code " << err << ". Exiting...\n";
+        return err;
+    }
+    cerr << files << " files written in " << taken.count() << " s.\n";
+
+    if (corpus > 0) {
+        start = chrono::steady_clock::now();
+        long bytes = generateCorpus(directory + "/corpus.txt", seed, corpus,
+                                    err);
+        taken = chrono::steady_clock::now() - start;
+        if (err) {
+            cerr << "Error code " << err << ". Exiting...\n";
+            return err;
+        }
+        cerr << bytes << " bytes of corpus written in " << taken.count();
+        cerr << " s, " << bytes / taken.count() / (1 << 20) << " MB/s.\n";
+    }
+
+    return NO_ERROR;
+}
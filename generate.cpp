@@ -0,0 +1,424 @@
+/* Workload generator functions
+ *
+ * This file contains the definitions for functions to generate key sheets
+ * and plaintext corpora.
+ */
+
+#include "errors.h"
+#include "generate.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+
+int const SYMBOL_BITS = 10; // Symbols drawn from each 10 bits of a number
+int const SPACES = 180; // Of 1 << SYMBOL_BITS symbols, for 4.7 letter words
+int const LETTER_FREQUENCIES[26] = {
+    82, 15, 28, 43, 127, 22, 20, 61, 70, 2, 8, 40, 24,
+    67, 75, 19, 1, 60, 63, 91, 28, 10, 24, 2, 20, 1
+}; // Per thousand letters of English text, A to Z
+
+
+/* 'Random' is a SplitMix64 stream. Streams with different numbers give
+   unrelated sequences from the same seed. */
+class Random {
+ public:
+    Random(unsigned long seed, unsigned long stream)
+        : state_(seed ^ (stream + 1) * 0x9e3779b97f4a7c15) {}
+
+    unsigned long next()
+    {
+        unsigned long z = (state_ += 0x9e3779b97f4a7c15);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+        return z ^ (z >> 31);
+    }
+
+    int below(int n)
+    { return next() % n; }
+
+ private:
+    unsigned long state_;
+};
+
+
+static unsigned noOfThreads()
+{
+    return max(1u, thread::hardware_concurrency());
+}
+
+
+static void buildSymbols(char symbols[])
+{
+    int total = 0, filled = SPACES, letters = (1 << SYMBOL_BITS) - SPACES;
+
+    for (int frequency : LETTER_FREQUENCIES)
+        total += frequency;
+
+    fill(symbols, symbols + SPACES, ' ');
+    for (int i = 0, sum = 0; i < 26; i++) {
+        sum += LETTER_FREQUENCIES[i];
+        int end = SPACES + (long) sum * letters / total;
+        fill(symbols + filled, symbols + end, 'A' + i);
+        filled = end;
+    } // Each letter's share rounded so that the shares add up exactly
+}
+
+
+static void fillBlock(Random& random, char const symbols[], char block[],
+                      long length)
+{
+    int column = 0;
+    long i = 0;
+
+    while (i < length) {
+        unsigned long bits = random.next();
+        for (int j = 0; j < 64 / SYMBOL_BITS && i < length; j++, i++) {
+            char ch = symbols[bits & ((1 << SYMBOL_BITS) - 1)];
+            bits >>= SYMBOL_BITS;
+            if (ch == ' ' && column >= CORPUS_LINE) {
+                ch = '\n';
+                column = 0;
+            } else
+                column++;
+            block[i] = ch;
+        }
+    }
+}
+
+
+long generateCorpus(string const& name, unsigned long seed, long bytes,
+                    int& err)
+{
+    int fd = open(name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0 || bytes < 2) {
+        cerr << "Error opening '" << name << "'.\n";
+        err = ERROR_OPENING_CONFIGURATION_FILE;
+        if (fd >= 0)
+            close(fd);
+        return 0;
+    }
+
+    char symbols[1 << SYMBOL_BITS];
+    buildSymbols(symbols);
+
+    long no_of_blocks = (bytes + CORPUS_BLOCK - 1) / CORPUS_BLOCK;
+    atomic<long> next_block(0), written(0);
+
+    auto worker = [&]() {
+        vector<char> block(CORPUS_BLOCK);
+        for (long b; (b = next_block++) < no_of_blocks; ) {
+            Random random(seed, b);
+            long offset = b * CORPUS_BLOCK;
+            long length = min(CORPUS_BLOCK, bytes - offset);
+            fillBlock(random, symbols, block.data(), length);
+            for (long end = bytes - 2; end < bytes; end++) {
+                if (end >= offset && end < offset + length)
+                    block[end - offset] = end == bytes - 2 ? '.' : '\n';
+            } // The last block may hold only the newline
+
+            long done = 0, n;
+            while (done < length &&
+                   (n = pwrite(fd, block.data() + done, length - done,
+                               offset + done)) > 0)
+                done += n;
+            written += done;
+        }
+    };
+
+    vector<thread> threads;
+    for (unsigned t = 1; t < noOfThreads(); t++)
+        threads.push_back(thread(worker));
+    worker();
+    for (thread& t : threads)
+        t.join();
+
+    if (close(fd) || written < bytes) {
+        cerr << "Error writing '" << name << "'.\n";
+        err = ERROR_OPENING_CONFIGURATION_FILE;
+    }
+
+    return written;
+}
+
+
+static void shuffled(Random& random, vector<int>& values, int n)
+{
+    values.resize(n);
+    for (int i = 0; i < n; i++)
+        values[i] = i;
+    for (int i = n - 1; i > 0; i--)
+        swap(values[i], values[random.below(i + 1)]);
+}
+
+
+static string numbers(vector<int> const& values)
+{
+    string text;
+
+    for (size_t i = 0; i < values.size(); i++) {
+        text += to_string(values[i]);
+        text += (i + 1 == values.size()) ? "\n" : " ";
+    }
+
+    return text;
+}
+
+
+static void plugboard(Random& random, int min_pairs, vector<int>& values)
+{
+    int pairs = min_pairs + random.below(14 - min_pairs);
+
+    shuffled(random, values, 26);
+    values.resize(2 * pairs);
+}
+
+
+static void rotor(Random& random, vector<int>& values)
+{
+    vector<int> notches;
+    int no_of_notches = 1 + random.below(MAX_NOTCHES);
+
+    shuffled(random, values, 26);
+    shuffled(random, notches, 26);
+    values.insert(values.end(), notches.begin(),
+                  notches.begin() + no_of_notches);
+}
+
+
+static void positions(Random& random, int depth, vector<int>& values)
+{
+    values.resize(depth);
+    for (int& value : values)
+        value = random.below(26);
+}
+
+
+static void breakToken(Random& random, vector<int> const& values,
+                       string& text, bool numeric)
+{
+    vector<string> tokens;
+    for (int value : values)
+        tokens.push_back(to_string(value));
+
+    int at = random.below(tokens.size());
+    if (numeric)
+        tokens[at] = string(1, 'a' + random.below(26));
+    else
+        tokens[at] = to_string(26 + random.below(74));
+
+    text.clear();
+    for (string const& token : tokens)
+        text += token + ' ';
+    text += '\n';
+}
+
+
+/* 'SheetWriter' writes the files of one key sheet, counting them. */
+struct SheetWriter {
+    string directory;
+    atomic<int>& files;
+    atomic<bool>& failed;
+
+    void write(string const& name, string const& text)
+    {
+        ofstream out(directory + '/' + name);
+        out << text;
+        out.close();
+
+        if (out.fail()) {
+            if (!failed.exchange(true))
+                cerr << "Error writing '" << directory << '/' << name
+                     << "'.\n";
+            return;
+        }
+        files++;
+    }
+};
+
+
+static void writeInvalid
+(SheetWriter& writer, Random& random, int i, int depth, string const& args,
+ vector<string>& cases)
+{
+    string sheet = to_string(i), bad = "invalid/" + sheet + "-";
+    string pb = sheet + ".pb", rf = sheet + ".rf", pos = sheet + ".pos";
+    string rotors, others, text, plain = "invalid/plain.txt";
+    vector<int> values;
+
+    for (int r = 0; r < depth; r++) {
+        string name = ' ' + sheet + '-' + to_string(r) + ".rot";
+        rotors += name;
+        if (r > 0)
+            others += name; // Every rotor but the first, which may be none
+    }
+
+    auto add = [&](int code, string const& input, string const& arguments) {
+        cases.push_back(to_string(code) + ' ' + input + ' ' + arguments);
+    };
+
+    add(INSUFFICIENT_NUMBER_OF_PARAMETERS, plain, pb);
+
+    text.clear();
+    for (int n = 1 + random.below(40), j = 0; j < n; j++)
+        text += 'A' + random.below(26);
+    text += "abcdefghijklmnopqrstuvwxyz0123456789!?"[random.below(38)];
+    writer.write(bad + "input.txt", text + "ENDE.\n");
+    add(INVALID_INPUT_CHARACTER, bad + "input.txt", args);
+
+    for (int numeric = 0; numeric < 2; numeric++) {
+        int code = numeric ? NON_NUMERIC_CHARACTER : INVALID_INDEX;
+        string what = numeric ? "numeric" : "index";
+
+        plugboard(random, 1, values);
+        breakToken(random, values, text, numeric);
+        writer.write(bad + what + ".pb", text);
+        add(code, plain, bad + what + ".pb " + rf + rotors + ' ' + pos);
+
+        shuffled(random, values, 26);
+        breakToken(random, values, text, numeric);
+        writer.write(bad + what + ".rf", text);
+        add(code, plain, pb + ' ' + bad + what + ".rf" + rotors + ' ' + pos);
+
+        rotor(random, values);
+        breakToken(random, values, text, numeric);
+        writer.write(bad + what + ".rot", text);
+        add(code, plain, pb + ' ' + rf + ' ' + bad + what + ".rot" +
+            others + ' ' + pos);
+        // In place of the first rotor, whose notches are also checked
+
+        positions(random, depth, values);
+        breakToken(random, values, text, numeric);
+        writer.write(bad + what + ".pos", text);
+        add(code, plain, pb + ' ' + rf + rotors + ' ' + bad + what + ".pos");
+    }
+
+    plugboard(random, 2, values);
+    values[2 * random.below(values.size() / 2) + 1] = values[0];
+    // A letter plugged twice, or to itself
+    writer.write(bad + "impossible.pb", numbers(values));
+    add(IMPOSSIBLE_PLUGBOARD_CONFIGURATION, plain,
+        bad + "impossible.pb " + rf + rotors + ' ' + pos);
+
+    shuffled(random, values, 26);
+    values.resize(2 * random.below(13) + 1);
+    writer.write(bad + "count.pb", numbers(values));
+    add(INCORRECT_NUMBER_OF_PLUGBOARD_PARAMETERS, plain,
+        bad + "count.pb " + rf + rotors + ' ' + pos);
+
+    rotor(random, values);
+    if (random.below(2))
+        values.resize(random.below(26)); // Too few mappings
+    else {
+        int from = random.below(26), to = (from + 1 + random.below(25)) % 26;
+        values[from] = values[to]; // Two inputs to one output
+    }
+    writer.write(bad + "mapping.rot", numbers(values));
+    add(INVALID_ROTOR_MAPPING, plain, pb + ' ' + rf + ' ' + bad +
+        "mapping.rot" + others + ' ' + pos);
+
+    positions(random, depth - 1, values);
+    writer.write(bad + "short.pos", numbers(values));
+    add(NO_ROTOR_STARTING_POSITION, plain,
+        pb + ' ' + rf + rotors + ' ' + bad + "short.pos");
+
+    shuffled(random, values, 26);
+    values[1 + 2 * random.below(13)] = values[0];
+    writer.write(bad + "mapping.rf", numbers(values));
+    add(INVALID_REFLECTOR_MAPPING, plain,
+        pb + ' ' + bad + "mapping.rf" + rotors + ' ' + pos);
+
+    shuffled(random, values, 26);
+    values.resize(2 * random.below(13) + random.below(2));
+    writer.write(bad + "count.rf", numbers(values));
+    add(INCORRECT_NUMBER_OF_REFLECTOR_PARAMETERS, plain,
+        pb + ' ' + bad + "count.rf" + rotors + ' ' + pos);
+
+    add(ERROR_OPENING_CONFIGURATION_FILE, plain,
+        pb + ' ' + rf + ' ' + bad + "missing.rot" +
+        others + ' ' + pos);
+}
+
+
+int generateSheets
+(string const& directory, unsigned long seed, int sheets, int depth,
+ bool invalid, int& err)
+{
+    atomic<int> next_sheet(0), files(0);
+    atomic<bool> failed(false);
+    vector<string> lines(sheets);
+    vector<vector<string> > cases(sheets);
+
+    if (invalid && mkdir((directory + "/invalid").c_str(), 0755) &&
+        errno != EEXIST) {
+        cerr << "Error opening '" << directory << "/invalid'.\n";
+        err = ERROR_OPENING_CONFIGURATION_FILE;
+        return 0;
+    }
+
+    auto worker = [&]() {
+        SheetWriter writer = {directory, files, failed};
+        vector<int> values;
+
+        for (int i; (i = next_sheet++) < sheets && !failed; ) {
+            Random random(~seed, i); // Apart from the corpus's streams
+            string sheet = to_string(i);
+            string& args = lines[i];
+
+            plugboard(random, 0, values);
+            writer.write(sheet + ".pb", numbers(values));
+            shuffled(random, values, 26);
+            writer.write(sheet + ".rf", numbers(values));
+            args = sheet + ".pb " + sheet + ".rf";
+
+            for (int r = 0; r < depth; r++) {
+                string name = sheet + '-' + to_string(r) + ".rot";
+                rotor(random, values);
+                writer.write(name, numbers(values));
+                args += ' ' + name;
+            }
+            positions(random, depth, values);
+            writer.write(sheet + ".pos", numbers(values));
+            args += ' ' + sheet + ".pos";
+
+            if (invalid)
+                writeInvalid(writer, random, i, depth, args, cases[i]);
+        }
+    };
+
+    vector<thread> threads;
+    for (unsigned t = 1; t < noOfThreads(); t++)
+        threads.push_back(thread(worker));
+    worker();
+    for (thread& t : threads)
+        t.join();
+
+    SheetWriter writer = {directory, files, failed};
+    string text;
+    for (string const& line : lines)
+        text += line + '\n';
+    writer.write("sheets.txt", text);
+
+    if (invalid) {
+        writer.write("invalid/plain.txt", "HELLOWORLD.\n");
+        text.clear();
+        for (auto const& sheet_cases : cases) {
+            for (string const& line : sheet_cases)
+                text += line + '\n';
+        }
+        writer.write("invalid/cases.txt", text);
+    }
+
+    if (failed)
+        err = ERROR_OPENING_CONFIGURATION_FILE;
+    return files;
+}
@@ -0,0 +1,55 @@
+/* Workload generator header file
+ *
+ * This file contains the header file for generating key sheets and
+ * plaintext corpora for load and soak testing.
+ */
+
+#ifndef GENERATE_H
+#define GENERATE_H
+
+#include <string>
+
+long const CORPUS_BLOCK = 1L << 22; // Bytes of corpus each task writes
+int const CORPUS_LINE = 72; // Columns before a space becomes a newline
+int const MAX_NOTCHES = 3; // Per generated rotor
+
+
+/* Everything generated depends only on the seed: each key sheet and each
+   block of the corpus draws from its own stream, seeded from the seed and
+   its index, so the output is the same on any number of threads. */
+
+
+long generateCorpus
+    (std::string const& name, unsigned long seed, long bytes, int& err);
+/* Precondition:
+   'bytes' is at least 2, and 'err' is the error code, currently set to
+   0. */
+/* Postcondition:
+   'name' holds 'bytes' bytes of plaintext, written a block at a time on
+   all hardware threads: letters drawn with English frequencies, split into
+   words by spaces and into lines by newlines, and ended by ".\n" as the
+   main program expects. If it cannot be written, an error message is
+   displayed and the error code changed. The number of bytes written is
+   returned. */
+
+int generateSheets
+    (std::string const& directory, unsigned long seed, int sheets,
+     int depth, bool invalid, int& err);
+/* Precondition:
+   'directory' exists, 'depth' is at least 1, and 'err' is the error code,
+   currently set to 0. */
+/* Postcondition:
+   For each of 'sheets' key sheets i, 'directory' holds a valid plugboard
+   i.pb, reflector i.rf, 'depth' rotors i-0.rot onwards with 1 to
+   MAX_NOTCHES notches each, and start positions i.pos, on all hardware
+   threads. Each line of sheets.txt gives the command line arguments for
+   one sheet, relative to 'directory'. If 'invalid' is true, each sheet
+   also gets broken copies of its files in invalid/, and each line of
+   invalid/cases.txt gives the error code from errors.h the main program
+   must exit with, the file to feed it on standard input, and its
+   arguments; every code is covered for every sheet. If a file cannot be
+   written, an error message is displayed and the error code changed. The
+   number of files written is returned. */
+
+
+#endif
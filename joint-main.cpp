@@ -0,0 +1,146 @@
+/* Joint key search program
+ *
+ * This file contains the main program for searching many intercepts sent
+ * under one daily key together. Usage:
+ * './joint [-s] [-k <top k>] <training text> <plugboard> <reflector>
+ *  <rotorI>...<rotorx>'
+ * The ciphertext files are named on standard input, one per line. Every
+ * order of three rotors from those given is tried, with each message from
+ * its own best start positions, or with '-s' all from the same ones. The
+ * best orders are printed with their combined scores and the start
+ * positions found for each message. */
+
+#include "errors.h"
+#include "enigma.h"
+#include "enumerator.h"
+#include "fidelis.h"
+#include "joint.h"
+#include "scorer.h"
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+
+int readCiphertext(string const& name, vector<int>& text)
+{
+    int err = NO_ERROR;
+    ifstream ct_file(name);
+    if ( (err = fileReadErr(name.c_str(), ct_file)) )
+        return err;
+
+    char ch;
+    ct_file >> ws >> ch;
+    while (ch != '.' && !ct_file.eof()) {
+        if (ch < 'A' || ch > 'Z') {
+            cerr << "\n'" << ch << "' is not a valid ciphertext character.\n";
+            return INVALID_INPUT_CHARACTER;
+        }
+        text.push_back(ch - 'A');
+        ct_file >> ws >> ch;
+    }
+
+    return NO_ERROR;
+}
+
+
+int main(int argc, char** argv)
+{
+    int err = NO_ERROR, top_k = 10;
+    bool shared_start = false;
+
+    while (argc > 1 && (string(argv[1]) == "-s" ||
+                        (argc > 2 && string(argv[1]) == "-k"))) {
+        if (string(argv[1]) == "-s") {
+            shared_start = true;
+            argc -= 1;
+            argv += 1;
+        } else {
+            top_k = atoi(argv[2]);
+            argc -= 2;
+            argv += 2;
+        } // The last option takes the place of the program name
+    }
+
+    if (argc < 4 + JOINT_ROTORS) {
+        cerr << "Too few command line parameters given.\n";
+        cerr << "'./joint [-s] [-k <top k>] <training text> <plugboard> ";
+        cerr << "<reflector> <rotorI>...<rotorx>', with at least ";
+        cerr << JOINT_ROTORS << " rotors\n\n";
+        return INSUFFICIENT_NUMBER_OF_PARAMETERS;
+    }
+
+    Scorer scorer;
+    ifstream training(argv[1]);
+    if ( (err = fileReadErr(argv[1], training)) )
+        return err;
+    scorer.train(training, err);
+    if (err) {
+        cerr << "Error code " << err << ". Exiting...\n";
+        return err;
+    }
+
+    vector<string> names;
+    vector<vector<int> > texts;
+    string name;
+    long letters = 0;
+    while (getline(cin, name)) {
+        if (name.empty())
+            continue;
+        texts.push_back(vector<int>());
+        if ( (err = readCiphertext(name, texts.back())) ) {
+            cerr << "Error code " << err << ". Exiting...\n";
+            return err;
+        }
+        names.push_back(name);
+        letters += texts.back().size();
+    }
+
+    Enigma<> base(JOINT_ROTORS);
+    char* config[3] = {argv[0], argv[2], argv[3]};
+    base.setConfig(3, config, err); // Plugboard and reflector only
+    if (err) {
+        cerr << "Error code " << err << ". Exiting...\n";
+        return err;
+    }
+
+    vector<Rotor> library(argc - 4);
+    for (int i = 4; i < argc; i++) {
+        library[i-4].load(argv[i], err);
+        if (err) {
+            cerr << "Error code " << err << ". Exiting...\n";
+            return err;
+        }
+    }
+
+    vector<JointResult> results;
+    TrialStats stats;
+    jointSearch(base, library, texts, scorer, shared_start, top_k, results,
+                stats);
+
+    vector<int> orders;
+    rotorOrders(library.size(), JOINT_ROTORS, orders);
+    for (JointResult const& result : results) {
+        for (int i = 0; i < JOINT_ROTORS; i++)
+            cout << argv[4 + orders[result.order * JOINT_ROTORS + i]] << ' ';
+        cout << " score " << result.score << '\n';
+        for (size_t m = 0; m < names.size(); m++) {
+            long key = result.starts[m];
+            cout << "    " << names[m] << ' ' << key / 676 << ' ';
+            cout << key / 26 % 26 << ' ' << key % 26 << '\n';
+        }
+    }
+
+    long states = orders.size() / JOINT_ROTORS * 26 * 26 * 26;
+    cerr << "\nMachine states walked: " << states << ", against ";
+    cerr << states * texts.size() << " searching each message alone.\n";
+    cerr << "Message trials: " << stats.candidates << ", rejected early: ";
+    cerr << stats.rejected << ". Letters decrypted: ";
+    cerr << stats.rejected_letters + stats.completed_letters << " of ";
+    cerr << states * letters << ".\n";
+
+    return NO_ERROR;
+}
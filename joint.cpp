@@ -0,0 +1,174 @@
+/* Joint key search functions
+ *
+ * This file contains the definitions for functions to search many
+ * intercepts sent under one daily key at once.
+ */
+
+#include "joint.h"
+#include "enumerator.h"
+#include <atomic>
+#include <cmath>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+
+void buildStates(Enigma<>& machine, StateTable& table)
+{
+    KeyEnumerator keys(machine);
+    int n = machine.rotorCount();
+    vector<int> positions(n);
+
+    table.permutations.resize(keys.size());
+    table.next.resize(keys.size());
+
+    for (keys.seek(0); keys.key() < keys.size(); keys.next()) {
+        table.permutations[keys.key()] = keys.permutation();
+        machine.setPositions(keys.positions());
+        machine.seek(1);
+        machine.getPositions(positions.data());
+
+        uint32_t next = 0;
+        for (int i = 0; i < n; i++)
+            next = next * 26 + positions[i];
+        table.next[keys.key()] = next;
+    } // Any stepping rule, since each state's successor is looked up
+}
+
+
+static bool scoreFrom
+(StateTable const& table, uint32_t start, vector<int> const& text,
+ Scorer const& scorer, double threshold, double& score, TrialStats& stats)
+{
+    Permutation const* permutations = table.permutations.data();
+    uint32_t const* next = table.next.data();
+    long length = text.size();
+    uint32_t state = next[start];
+    int prev = Scorer::START;
+
+    stats.candidates++;
+    score = 0;
+
+    for (long i = 0; i < length; i++, state = next[state]) {
+        int letter = permutations[state][text[i]];
+        score += scorer.step(prev, letter);
+        prev = letter;
+
+        if (score + scorer.bound(length - 1 - i) < threshold) {
+            stats.rejected++;
+            stats.rejected_letters += i + 1;
+            return false;
+        }
+    } // As trialDecrypt, with the key presses looked up
+
+    stats.completed_letters += length;
+    return true;
+}
+
+
+void jointSearch
+(Enigma<> const& base, vector<Rotor> const& library,
+ vector<vector<int> > const& texts, Scorer const& scorer, bool shared_start,
+ int top_k, vector<JointResult>& results, TrialStats& stats)
+{
+    vector<int> orders;
+    rotorOrders(library.size(), JOINT_ROTORS, orders);
+    int no_of_orders = orders.size() / JOINT_ROTORS;
+    int no_of_texts = texts.size();
+
+    vector<double> rest(no_of_texts + 1, 0);
+    for (int m = no_of_texts - 1; m >= 0; m--)
+        rest[m] = rest[m + 1] + scorer.bound(texts[m].size());
+    // The most the messages from m on could add to a combined score
+
+    vector<vector<long> > all_starts(no_of_orders);
+    atomic<int> next_order(0);
+    TopK best(top_k);
+    mutex lock;
+    long no_of_states = 1;
+    for (int i = 0; i < JOINT_ROTORS; i++)
+        no_of_states *= 26;
+
+    auto worker = [&]() {
+        Enigma<> machine(base);
+        StateTable table;
+        TopK found(top_k);
+        TrialStats counts;
+        double score;
+
+        for (int order; (order = next_order++) < no_of_orders; ) {
+            for (int i = 0; i < JOINT_ROTORS; i++)
+                machine.setRotor(i, library[orders[order * JOINT_ROTORS + i]]);
+            buildStates(machine, table);
+
+            if (shared_start) {
+                for (long start = 0; start < no_of_states; start++) {
+                    double total = 0;
+                    int m = 0;
+                    for (; m < no_of_texts; m++) {
+                        double need = found.threshold() - total - rest[m + 1];
+                        if (!scoreFrom(table, start, texts[m], scorer, need,
+                                       score, counts))
+                            break;
+                        total += score;
+                    }
+                    if (m == no_of_texts)
+                        found.offer(total, order * no_of_states + start);
+                }
+                continue;
+            }
+
+            vector<long>& starts = all_starts[order];
+            double total = 0;
+            starts.assign(no_of_texts, -1);
+            for (int m = 0; m < no_of_texts; m++) {
+                double need = found.threshold() - total - rest[m + 1];
+                double best_score = -INFINITY;
+                for (long start = 0; start < no_of_states; start++) {
+                    if (scoreFrom(table, start, texts[m], scorer,
+                                  max(need, best_score), score, counts) &&
+                        score > best_score) {
+                        best_score = score;
+                        starts[m] = start;
+                    }
+                }
+                if (starts[m] < 0)
+                    break; // No start lets the order reach the top
+                total += best_score;
+            }
+            if (no_of_texts == 0 || starts.back() >= 0)
+                found.offer(total, order);
+        }
+
+        lock_guard<mutex> hold(lock);
+        for (auto const& entry : found.results())
+            best.offer(entry.first, entry.second);
+        stats.candidates += counts.candidates;
+        stats.rejected += counts.rejected;
+        stats.rejected_letters += counts.rejected_letters;
+        stats.completed_letters += counts.completed_letters;
+    };
+
+    vector<thread> threads;
+    for (unsigned t = 1; t < thread::hardware_concurrency(); t++)
+        threads.push_back(thread(worker));
+    worker();
+    for (thread& t : threads)
+        t.join();
+
+    results.clear();
+    for (auto const& entry : best.results()) {
+        JointResult result;
+        result.score = entry.first;
+        if (shared_start) {
+            result.order = entry.second / no_of_states;
+            result.starts.assign(no_of_texts, entry.second % no_of_states);
+        } else {
+            result.order = entry.second;
+            result.starts = all_starts[entry.second];
+        }
+        results.push_back(result);
+    }
+}
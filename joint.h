@@ -0,0 +1,71 @@
+/* Joint key search header file
+ *
+ * This file contains the header file for searching many intercepts sent
+ * under one daily key at once.
+ */
+
+#ifndef JOINT_H
+#define JOINT_H
+
+#include "enigma.h"
+#include "permutation.h"
+#include "rotor.h"
+#include "scorer.h"
+#include <cstdint>
+#include <vector>
+
+int const JOINT_ROTORS = 3; // Rotors in the machine, chosen from the library
+
+
+/* Intercepts sent under one daily key share the rotor order and plugboard.
+   Searching them one at a time steps the machine through every state once
+   per message; instead, each rotor order's states are walked once into a
+   'StateTable', and every message is then decrypted from every start by
+   table lookups alone. The scores of all the messages are added together,
+   so an order is judged on all the text at once. */
+
+
+/* 'StateTable' is every state of one machine: the permutation a key press
+   applies on reaching each state, and the state each goes on to. States are
+   numbered as KeyEnumerator keys. */
+struct StateTable {
+    std::vector<Permutation> permutations;
+    std::vector<uint32_t> next;
+};
+
+
+/* 'JointResult' is one rotor order, with the start of each message and the
+   combined score. */
+struct JointResult {
+    double score;
+    int order;
+    std::vector<long> starts; // Keys, as KeyEnumerator numbers them
+};
+
+
+void buildStates(Enigma<>& machine, StateTable& table);
+/* Precondition:
+   'machine' is configured, with at most 6 rotors. */
+/* Postcondition:
+   'table' holds every state of the machine. The machine's positions are
+   left changed. */
+
+void jointSearch
+    (Enigma<> const& base, std::vector<Rotor> const& library,
+     std::vector<std::vector<int> > const& texts, Scorer const& scorer,
+     bool shared_start, int top_k, std::vector<JointResult>& results,
+     TrialStats& stats);
+/* Precondition:
+   'base' has its plugboard and reflector set and room for JOINT_ROTORS
+   rotors, and 'texts' holds each ciphertext as integers between 0 and
+   25. */
+/* Postcondition:
+   Every rotor order from 'library' has been tried, the orders split
+   between all hardware threads, each building its table once. Each
+   message is given its own best start, unless 'shared_start' is true, when
+   all the messages are taken to start from the same positions. 'results'
+   holds the best 'top_k' by combined score, best first. A message or order
+   is abandoned as soon as Scorer::bound shows it cannot reach the top. */
+
+
+#endif
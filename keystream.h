@@ -0,0 +1,165 @@
+/* Keystream generator header file
+ *
+ * This file contains the keystream generator class template. It is defined
+ * entirely here, as it is a thin template over Enigma.
+ */
+
+#ifndef KEYSTREAM_H
+#define KEYSTREAM_H
+
+#include "enigma.h"
+#include "permutation.h"
+#include <vector>
+
+
+/* The 'Keystream' class yields, one key press at a time, the substitution
+   the machine applies: step k of the stream is the permutation a k'th key
+   press would encrypt with. Steps are generated only when pulled, from a
+   private copy of the machine, with no allocation after construction.
+   'take(n)' gives a range for range-based for loops:
+
+     Keystream<> stream(enigma);
+     for (Permutation const& step : stream.take(100))
+         ...
+
+   and 'fill' writes steps straight into a caller's buffer. */
+template <class Stepping = OdometerStepping>
+class Keystream {
+ public:
+    Keystream(Enigma<Stepping> const& enigma); // Constructor
+
+    Permutation const& next();
+    /* Postcondition:
+       The machine is turned by one key press, and the substitution for
+       that press is returned. */
+
+    void fill(Permutation steps[], long n);
+    /* Precondition:
+       'steps' has space for 'n' permutations. */
+    /* Postcondition:
+       'steps' holds the next 'n' substitutions. */
+
+    void fillStates(long states[], long n);
+    /* Precondition:
+       'states' has space for 'n' numbers. */
+    /* Postcondition:
+       'states' holds the rotor state of the next 'n' key presses, each the
+       positions after the press read as a base 26 number, leftmost rotor
+       first, for machines of up to 13 rotors. This is all a consumer needs
+       to index its own tables. */
+
+    class Iterator;
+    class Range;
+
+    Range take(long n);
+    /* Postcondition:
+       A range over the next 'n' substitutions is returned. Each one is
+       generated as the range is iterated. */
+
+ private:
+    Enigma<Stepping> machine_;
+    Permutation current_;
+    bool pending_; // A range has moved on, but not yet generated the step
+    std::vector<int> positions_;
+};
+
+
+/* 'Iterator' walks a 'Range'. Dereferencing gives the current step, which
+   stays valid until the iterator is moved on. */
+template <class Stepping>
+class Keystream<Stepping>::Iterator {
+ public:
+    Iterator(Keystream* stream, long step) : stream_(stream), step_(step) {}
+
+    Permutation const& operator*() const
+    {
+        if (stream_->pending_)
+            stream_->next();
+        return stream_->current_;
+    }
+
+    Iterator& operator++()
+    {
+        if (stream_->pending_)
+            stream_->next(); // Skipped without being looked at
+        stream_->pending_ = true;
+        step_++;
+        return *this;
+    }
+
+    bool operator!=(Iterator const& other) const
+    { return step_ != other.step_; }
+
+ private:
+    Keystream* stream_;
+    long step_;
+};
+
+
+template <class Stepping>
+class Keystream<Stepping>::Range {
+ public:
+    Range(Keystream* stream, long n) : stream_(stream), n_(n) {}
+
+    Iterator begin()
+    {
+        stream_->pending_ = true; // Each step is generated when looked at
+        return Iterator(stream_, 0);
+    }
+
+    Iterator end()
+    { return Iterator(stream_, n_); }
+
+ private:
+    Keystream* stream_;
+    long n_;
+};
+
+
+template <class Stepping>
+Keystream<Stepping>::Keystream(Enigma<Stepping> const& enigma)
+    : machine_(enigma), pending_(false), positions_(enigma.rotorCount())
+{
+}
+
+
+template <class Stepping>
+Permutation const& Keystream<Stepping>::next()
+{
+    machine_.seek(1);
+    current_ = machine_.permutation();
+    pending_ = false;
+    return current_;
+}
+
+
+template <class Stepping>
+void Keystream<Stepping>::fill(Permutation steps[], long n)
+{
+    for (long i = 0; i < n; i++)
+        steps[i] = next();
+}
+
+
+template <class Stepping>
+void Keystream<Stepping>::fillStates(long states[], long n)
+{
+    for (long i = 0; i < n; i++) {
+        machine_.seek(1);
+        machine_.getPositions(positions_.data());
+        states[i] = 0;
+        for (int position : positions_)
+            states[i] = states[i] * 26 + position;
+    }
+    pending_ = false;
+}
+
+
+template <class Stepping>
+typename Keystream<Stepping>::Range Keystream<Stepping>::take(long n)
+{
+    return Range(this, n);
+}
+
+
+#endif
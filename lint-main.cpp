@@ -0,0 +1,33 @@
+/* Configuration linter program
+ * 
+ * This file contains the main program for the configuration linter. Usage:
+ * './lint <directory or config file>'
+ * Every problem found is printed as one JSON object per line, and the exit
+ * status is 1 if there were any. */
+
+#include "errors.h"
+#include "lint.h"
+#include <iostream>
+
+using namespace std;
+
+
+int main(int argc, char** argv)
+{
+    int err = NO_ERROR;
+
+    if (argc != 2) {
+        cerr << "Incorrect number of command line parameters given.\n";
+        cerr << "'./lint <directory or config file>'\n\n";
+        return INSUFFICIENT_NUMBER_OF_PARAMETERS;
+    }
+
+    int problems = lintTree(argv[1], cout, err);
+    if (err) {
+        cerr << "Error code " << err << ". Exiting...\n";
+        return err;
+    }
+
+    cerr << problems << " problems found.\n";
+    return problems ? 1 : NO_ERROR;
+}
@@ -0,0 +1,373 @@
+/* Configuration linter functions
+ *
+ * This file contains the definitions for functions to check config files
+ * held in memory, and to check whole directory trees of them in parallel.
+ */
+
+#include "errors.h"
+#include "lint.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <fcntl.h>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+
+static char const* const ERROR_NAMES[] = {
+    "NO_ERROR",
+    "INSUFFICIENT_NUMBER_OF_PARAMETERS",
+    "INVALID_INPUT_CHARACTER",
+    "INVALID_INDEX",
+    "NON_NUMERIC_CHARACTER",
+    "IMPOSSIBLE_PLUGBOARD_CONFIGURATION",
+    "INCORRECT_NUMBER_OF_PLUGBOARD_PARAMETERS",
+    "INVALID_ROTOR_MAPPING",
+    "NO_ROTOR_STARTING_POSITION",
+    "INVALID_REFLECTOR_MAPPING",
+    "INCORRECT_NUMBER_OF_REFLECTOR_PARAMETERS",
+    "ERROR_OPENING_CONFIGURATION_FILE"
+}; // Indexed by the codes in errors.h
+
+
+/* 'Token' is one whitespace separated word of a config file. */
+struct Token {
+    size_t offset;
+    size_t length;
+    int value; // -1 if not a number, 26 or more if out of bounds
+};
+
+
+ConfigKind configKind(string const& filename)
+{
+    string extension = filesystem::path(filename).extension().string();
+
+    if (extension == ".pb")
+        return PLUGBOARD;
+    if (extension == ".rf")
+        return REFLECTOR;
+    if (extension == ".rot")
+        return ROTOR;
+    if (extension == ".pos")
+        return POSITIONS;
+
+    return NOT_CONFIG;
+}
+
+
+static void addProblem
+(vector<LintProblem>& problems, int code, size_t offset, size_t length,
+ string const& message)
+{
+    LintProblem problem = {code, offset, length, message};
+    problems.push_back(problem);
+}
+
+
+static bool checkToken
+(char const data[], Token const& token, vector<LintProblem>& problems)
+{
+    if (token.value < 0) {
+        size_t bad = token.offset;
+        while (isdigit((unsigned char) data[bad]))
+            bad++;
+        string shown(1, data[bad]);
+        if ((unsigned char) data[bad] >= 0x80) {
+            char byte[8];
+            snprintf(byte, sizeof(byte), "\\x%02x", (unsigned char) data[bad]);
+            shown = byte;
+        } // A lone byte of a multibyte character is not valid UTF-8
+        addProblem(problems, NON_NUMERIC_CHARACTER, bad, 1,
+                   "Non-numeric character '" + shown + "'");
+        return false;
+    }
+
+    if (token.value > 25) {
+        addProblem(problems, INVALID_INDEX, token.offset, token.length,
+                   "Out of bounds input '" +
+                   string(data + token.offset, token.length) + "'");
+        return false;
+    }
+
+    return true;
+}
+
+
+static void lintPairs
+(char const data[], size_t size, vector<Token> const& tokens,
+ bool plugboard, vector<LintProblem>& problems)
+{
+    int code = plugboard ? IMPOSSIBLE_PLUGBOARD_CONFIGURATION
+                         : INVALID_REFLECTOR_MAPPING;
+    string what = plugboard ? "plugboard" : "reflector";
+    long first_use[26]; // Offset each value was first mapped at, or -1
+    fill(first_use, first_use + 26, -1);
+
+    for (size_t i = 0; i < tokens.size(); i++) {
+        Token const& token = tokens[i];
+        if (!checkToken(data, token, problems))
+            continue;
+
+        if (i % 2 && tokens[i-1].value == token.value) {
+            addProblem(problems, code, token.offset, token.length,
+                       "Idempotent mapping '" + to_string(token.value) + "'");
+            continue;
+        }
+        if (first_use[token.value] >= 0) {
+            addProblem(problems, code, token.offset, token.length,
+                       "Overlapping " + what + " mapping '" +
+                       to_string(token.value) + "', first given at offset " +
+                       to_string(first_use[token.value]));
+            continue;
+        }
+        first_use[token.value] = token.offset;
+    }
+
+    size_t n = tokens.size();
+    if (plugboard && (n % 2 || n > 26))
+        addProblem(problems, INCORRECT_NUMBER_OF_PLUGBOARD_PARAMETERS, size, 0,
+                   to_string(n) + " mappings given, must contain an even "
+                   "number less than or equal to 26");
+    if (!plugboard && n != 26)
+        addProblem(problems, INCORRECT_NUMBER_OF_REFLECTOR_PARAMETERS, size, 0,
+                   to_string(n) + " mappings given, must contain 26");
+}
+
+
+static void lintRotor
+(char const data[], size_t size, vector<Token> const& tokens,
+ vector<LintProblem>& problems)
+{
+    long first_use[26];
+    fill(first_use, first_use + 26, -1);
+
+    for (size_t i = 0; i < tokens.size(); i++) {
+        Token const& token = tokens[i];
+        if (!checkToken(data, token, problems) || i >= 26)
+            continue; // From the 27th number on, the notches
+
+        if (first_use[token.value] >= 0) {
+            addProblem(problems, INVALID_ROTOR_MAPPING, token.offset,
+                       token.length, "Overlapping rotor mapping '" +
+                       to_string(token.value) + "', first given at offset " +
+                       to_string(first_use[token.value]));
+            continue;
+        }
+        first_use[token.value] = token.offset;
+    }
+
+    if (tokens.size() < 26)
+        addProblem(problems, INVALID_ROTOR_MAPPING, size, 0,
+                   "Insufficient rotor mappings; " + to_string(tokens.size()) +
+                   " given, must contain at least 26");
+}
+
+
+void lintConfig
+(char const data[], size_t size, ConfigKind kind, vector<LintProblem>& problems)
+{
+    vector<Token> tokens;
+
+    problems.clear();
+    for (size_t at = 0; at < size; ) {
+        if (isspace((unsigned char) data[at])) {
+            at++;
+            continue;
+        }
+
+        Token token = {at, 0, 0};
+        for (; at < size && !isspace((unsigned char) data[at]); at++) {
+            if (!isdigit((unsigned char) data[at]))
+                token.value = -1;
+            else if (token.value >= 0 && token.value < 1000)
+                token.value = token.value * 10 + (data[at] - '0');
+            // Capped, since any value over 25 is out of bounds anyway
+        }
+        token.length = at - token.offset;
+        tokens.push_back(token);
+    }
+
+    switch (kind) {
+    case PLUGBOARD:
+    case REFLECTOR:
+        lintPairs(data, size, tokens, kind == PLUGBOARD, problems);
+        break;
+    case ROTOR:
+        lintRotor(data, size, tokens, problems);
+        break;
+    case POSITIONS:
+        for (Token const& token : tokens)
+            checkToken(data, token, problems);
+        break;
+    case NOT_CONFIG:
+        break;
+    }
+}
+
+
+static size_t utf8Length(string const& text, size_t at)
+{
+    unsigned char lead = text[at];
+    size_t length;
+    unsigned char low = 0x80, high = 0xbf; // Range of the second byte
+
+    if (lead < 0x80)
+        return 1;
+    if (lead >= 0xc2 && lead <= 0xdf)
+        length = 2;
+    else if (lead >= 0xe0 && lead <= 0xef) {
+        length = 3;
+        if (lead == 0xe0)
+            low = 0xa0; // Overlong
+        if (lead == 0xed)
+            high = 0x9f; // Surrogates
+    } else if (lead >= 0xf0 && lead <= 0xf4) {
+        length = 4;
+        if (lead == 0xf0)
+            low = 0x90; // Overlong
+        if (lead == 0xf4)
+            high = 0x8f; // Beyond U+10FFFF
+    } else
+        return 0;
+
+    if (at + length > text.size())
+        return 0;
+    for (size_t i = 1; i < length; i++) {
+        unsigned char next = text[at + i];
+        if (next < (i == 1 ? low : 0x80) || next > (i == 1 ? high : 0xbf))
+            return 0;
+    }
+
+    return length;
+}
+
+
+static string jsonString(string const& text)
+{
+    string quoted = "\"";
+
+    for (size_t i = 0; i < text.size(); ) {
+        unsigned char ch = text[i];
+        size_t length = utf8Length(text, i);
+        if (ch == '"' || ch == '\\')
+            quoted += string("\\") + text[i];
+        else if (ch < 0x20 || !length) {
+            char escape[8];
+            snprintf(escape, sizeof(escape), "\\u%04x", ch);
+            quoted += escape;
+            // A file name need not be UTF-8; its stray bytes are escaped
+            // one at a time so the output still parses
+        } else
+            quoted += text.substr(i, length);
+        i += length ? length : 1;
+    }
+
+    return quoted + "\"";
+}
+
+
+static bool readWhole(string const& filename, vector<char>& buffer)
+{
+    int fd = open(filename.c_str(), O_RDONLY);
+    struct stat info;
+
+    if (fd < 0)
+        return false;
+    if (fstat(fd, &info)) {
+        close(fd);
+        return false;
+    }
+
+    buffer.resize(info.st_size);
+    size_t got = 0;
+    while (got < buffer.size()) {
+        ssize_t n = read(fd, buffer.data() + got, buffer.size() - got);
+        if (n < 0) {
+            close(fd);
+            return false;
+        }
+        if (n == 0)
+            break;
+        got += n;
+    }
+    buffer.resize(got); // In case the file shrank meanwhile
+    close(fd);
+
+    return true;
+}
+
+
+int lintTree(string const& root, ostream& outs, int& err)
+{
+    vector<string> files;
+    error_code fs_err;
+
+    if (!filesystem::exists(root, fs_err)) {
+        cerr << "Error opening '" << root << "'.\n";
+        err = ERROR_OPENING_CONFIGURATION_FILE;
+        return 0;
+    }
+
+    if (filesystem::is_directory(root, fs_err)) {
+        filesystem::recursive_directory_iterator walk
+            (root, filesystem::directory_options::skip_permission_denied,
+             fs_err);
+        for (; !fs_err && walk != filesystem::recursive_directory_iterator();
+             walk.increment(fs_err)) {
+            if (walk->is_regular_file(fs_err) &&
+                configKind(walk->path().string()) != NOT_CONFIG)
+                files.push_back(walk->path().string());
+        }
+    } else
+        files.push_back(root);
+    sort(files.begin(), files.end());
+
+    vector<string> records(files.size());
+    atomic<size_t> next_file(0);
+    atomic<int> total(0);
+
+    auto worker = [&]() {
+        vector<char> buffer; // Reused for every file this thread reads
+        vector<LintProblem> problems;
+
+        for (size_t i; (i = next_file++) < files.size(); ) {
+            string const prefix = "{\"file\":" + jsonString(files[i]);
+            if (!readWhole(files[i], buffer)) {
+                LintProblem unreadable = {ERROR_OPENING_CONFIGURATION_FILE,
+                                          0, 0, "Error opening file"};
+                problems.assign(1, unreadable);
+            } else
+                lintConfig(buffer.data(), buffer.size(),
+                           configKind(files[i]), problems);
+
+            for (LintProblem const& problem : problems) {
+                records[i] += prefix + ",\"code\":" + to_string(problem.code) +
+                    ",\"error\":\"" + ERROR_NAMES[problem.code] +
+                    "\",\"offset\":" + to_string(problem.offset) +
+                    ",\"length\":" + to_string(problem.length) +
+                    ",\"message\":" + jsonString(problem.message) + "}\n";
+            }
+            total += problems.size();
+        }
+    };
+
+    vector<thread> threads;
+    for (unsigned t = 1; t < thread::hardware_concurrency(); t++)
+        threads.push_back(thread(worker));
+    worker();
+    for (thread& t : threads)
+        t.join();
+
+    for (string const& record : records)
+        outs << record;
+
+    err = NO_ERROR;
+    return total;
+}
@@ -0,0 +1,58 @@
+/* Configuration linter header file
+ *
+ * This file contains the header file for the configuration linter, which
+ * checks whole directory trees of config files without loading a machine.
+ */
+
+#ifndef LINT_H
+#define LINT_H
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+
+/* The kinds of config file, told apart by their extension. */
+enum ConfigKind { PLUGBOARD, REFLECTOR, ROTOR, POSITIONS, NOT_CONFIG };
+
+
+/* 'LintProblem' is one problem found in a config file. 'offset' and 'length'
+   give the bytes at fault; a problem with the file as a whole, such as the
+   wrong number of mappings, points at the end of the file with length 0. */
+struct LintProblem {
+    int code; // As in errors.h
+    std::size_t offset;
+    std::size_t length;
+    std::string message;
+};
+
+
+ConfigKind configKind(std::string const& filename);
+/* Postcondition:
+   The kind of config file 'filename' names is returned, going by its
+   extension (.pb, .rf, .rot or .pos), or NOT_CONFIG. */
+
+void lintConfig
+    (char const data[], std::size_t size, ConfigKind kind,
+     std::vector<LintProblem>& problems);
+/* Precondition:
+   'data' holds the 'size' bytes of a config file of kind 'kind'. */
+/* Postcondition:
+   'problems' holds every problem the machine's own checks would stop at,
+   in file order, carrying on past each one where the file still makes
+   sense. It is empty if the file is valid. */
+
+int lintTree(std::string const& root, std::ostream& outs, int& err);
+/* Precondition:
+   'root' is a directory or a single config file, and 'err' is the error
+   code, currently set to 0. */
+/* Postcondition:
+   Every config file under 'root' is read once and checked, on all
+   hardware threads. One JSON object per problem is written to 'outs', one
+   per line, ordered by file name. The number of problems is returned. If
+   'root' cannot be read, an error message is displayed and the error code
+   changed. */
+
+
+#endif
@@ -3,18 +3,22 @@
  * Author: Philip Cai 
  * Last modified: 16/11/2018
  * 
- * This file contains the main program. */
+ * This file contains the main program. '-m <stepping>' before the config
+ * files picks how the rotors turn: odometer (the default), double or
+ * cogwheel, as described in stepping.h. */
 
 #include "errors.h"
 #include "enigma.h"
 #include <iostream>
+#include <string>
 
 using namespace std;
 
 
-int main(int argc, char** argv)
-{   
-    Enigma enigma(argc - 4);
+template <class Stepping>
+int run(int argc, char** argv)
+{
+    Enigma<Stepping> enigma(argc - 4);
     int err = NO_ERROR;
 
     enigma.setConfig(argc, argv, err);
@@ -32,3 +36,26 @@ int main(int argc, char** argv)
     cerr << "\nNo error. Program terminating...\n";
     return NO_ERROR;
 }
+
+
+int main(int argc, char** argv)
+{   
+    string stepping = "odometer";
+
+    if (argc > 2 && string(argv[1]) == "-m") {
+        stepping = argv[2];
+        argc -= 2;
+        argv += 2; // argv[2] takes the place of the program name
+    }
+
+    if (stepping == "odometer")
+        return run<OdometerStepping>(argc, argv);
+    if (stepping == "double")
+        return run<DoubleStepping>(argc, argv);
+    if (stepping == "cogwheel")
+        return run<CogwheelStepping>(argc, argv);
+
+    cerr << "Unknown stepping '" << stepping << "'; must be odometer, ";
+    cerr << "double or cogwheel.\n";
+    return INSUFFICIENT_NUMBER_OF_PARAMETERS;
+}
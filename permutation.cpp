@@ -0,0 +1,193 @@
+/* Permutation class member functions
+ *
+ * This file contains the definitions for member functions to compose,
+ * invert, apply and decompose permutations of the 26 letters. Composition
+ * and substitution use AVX2 or SSSE3 byte shuffles when the compiler
+ * targets them, and a plain table lookup otherwise.
+ */
+
+#include "permutation.h"
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <vector>
+#if defined(__AVX2__) || defined(__SSSE3__)
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+
+Permutation::Permutation()
+{
+    for (int i = 0; i < 32; i++)
+        map_[i] = i;
+}
+
+
+Permutation::Permutation(int const map[])
+{
+    for (int i = 0; i < 26; i++)
+        map_[i] = map[i];
+    for (int i = 26; i < 32; i++)
+        map_[i] = i;
+}
+
+
+Permutation Permutation::then(Permutation const& next) const
+{
+    Permutation result;
+
+#if defined(__AVX2__)
+    __m256i index = _mm256_load_si256((__m256i const*) map_);
+    __m256i table = _mm256_load_si256((__m256i const*) next.map_);
+    // A shuffle only looks up within its own 16-byte lane, so both halves
+    // of the table are copied across both lanes and the right one picked
+    __m256i low = _mm256_permute2x128_si256(table, table, 0x00);
+    __m256i high = _mm256_permute2x128_si256(table, table, 0x11);
+    __m256i from_high = _mm256_cmpgt_epi8(index, _mm256_set1_epi8(15));
+    __m256i mapped = _mm256_blendv_epi8
+        (_mm256_shuffle_epi8(low, index), _mm256_shuffle_epi8(high, index),
+         from_high);
+    _mm256_store_si256((__m256i*) result.map_, mapped);
+#elif defined(__SSSE3__)
+    __m128i low = _mm_load_si128((__m128i const*) next.map_);
+    __m128i high = _mm_load_si128((__m128i const*) (next.map_ + 16));
+    for (int half = 0; half < 32; half += 16) {
+        __m128i index = _mm_load_si128((__m128i const*) (map_ + half));
+        __m128i from_high = _mm_cmpgt_epi8(index, _mm_set1_epi8(15));
+        __m128i mapped = _mm_or_si128
+            (_mm_andnot_si128(from_high, _mm_shuffle_epi8(low, index)),
+             _mm_and_si128(from_high, _mm_shuffle_epi8(high, index)));
+        _mm_store_si128((__m128i*) (result.map_ + half), mapped);
+    }
+#else
+    for (int i = 0; i < 32; i++)
+        result.map_[i] = next.map_[map_[i]];
+#endif
+
+    return result;
+}
+
+
+Permutation Permutation::inverse() const
+{
+    Permutation result;
+
+    for (int i = 0; i < 26; i++)
+        result.map_[map_[i]] = i;
+
+    return result;
+}
+
+
+void Permutation::substitute
+(char const input[], char output[], long length) const
+{
+    alignas(32) char letters[32];
+    long i = 0;
+
+    for (int j = 0; j < 32; j++)
+        letters[j] = map_[j] + 'A';
+
+#if defined(__AVX2__)
+    __m256i table = _mm256_load_si256((__m256i const*) letters);
+    __m256i low = _mm256_permute2x128_si256(table, table, 0x00);
+    __m256i high = _mm256_permute2x128_si256(table, table, 0x11);
+    __m256i a = _mm256_set1_epi8('A'), fifteen = _mm256_set1_epi8(15);
+    for (; i + 32 <= length; i += 32) {
+        __m256i index = _mm256_sub_epi8
+            (_mm256_loadu_si256((__m256i const*) (input + i)), a);
+        __m256i mapped = _mm256_blendv_epi8
+            (_mm256_shuffle_epi8(low, index),
+             _mm256_shuffle_epi8(high, index),
+             _mm256_cmpgt_epi8(index, fifteen));
+        _mm256_storeu_si256((__m256i*) (output + i), mapped);
+    }
+#elif defined(__SSSE3__)
+    __m128i low = _mm_load_si128((__m128i const*) letters);
+    __m128i high = _mm_load_si128((__m128i const*) (letters + 16));
+    __m128i a = _mm_set1_epi8('A'), fifteen = _mm_set1_epi8(15);
+    for (; i + 16 <= length; i += 16) {
+        __m128i index = _mm_sub_epi8
+            (_mm_loadu_si128((__m128i const*) (input + i)), a);
+        __m128i from_high = _mm_cmpgt_epi8(index, fifteen);
+        __m128i mapped = _mm_or_si128
+            (_mm_andnot_si128(from_high, _mm_shuffle_epi8(low, index)),
+             _mm_and_si128(from_high, _mm_shuffle_epi8(high, index)));
+        _mm_storeu_si128((__m128i*) (output + i), mapped);
+    }
+#endif
+    for (; i < length; i++)
+        output[i] = letters[input[i] - 'A'];
+}
+
+
+Permutation Permutation::conjugate(int offset) const
+{
+    return shift(offset).then(*this).then(shift((26 - offset) % 26));
+}
+
+
+void Permutation::cycleLengths(vector<int>& lengths) const
+{
+    bool seen[26] = {};
+
+    lengths.clear();
+    for (int start = 0; start < 26; start++) {
+        int length = 0;
+        for (int x = start; !seen[x]; x = map_[x]) {
+            seen[x] = true;
+            length++;
+        }
+        if (length)
+            lengths.push_back(length);
+    }
+
+    sort(lengths.begin(), lengths.end(), greater<int>());
+}
+
+
+void Permutation::cycles(vector<vector<int> >& cycles) const
+{
+    bool seen[26] = {};
+
+    cycles.clear();
+    for (int start = 0; start < 26; start++) {
+        if (seen[start])
+            continue;
+        cycles.push_back(vector<int>());
+        for (int x = start; !seen[x]; x = map_[x]) {
+            seen[x] = true;
+            cycles.back().push_back(x);
+        }
+    }
+}
+
+
+bool Permutation::operator==(Permutation const& other) const
+{
+    return memcmp(map_, other.map_, 26) == 0;
+}
+
+
+bool Permutation::operator!=(Permutation const& other) const
+{
+    return !(*this == other);
+}
+
+
+Permutation Permutation::shift(int offset)
+{
+    static Permutation const* shifts = [] {
+        static Permutation table[26];
+        for (int k = 0; k < 26; k++) {
+            for (int i = 0; i < 26; i++)
+                table[k].map_[i] = (i + k) % 26;
+        }
+        return table;
+    }();
+    // Built once, on first use
+
+    return shifts[offset];
+}
@@ -0,0 +1,78 @@
+/* Permutation class header file
+ *
+ * This file contains the header file for the permutation class, which the
+ * precomputation and cryptanalysis tools build on.
+ */
+
+#ifndef PERMUTATION_H
+#define PERMUTATION_H
+
+#include <vector>
+
+
+/* The 'Permutation' class is a permutation of the 26 letters, stored as a
+   32-byte aligned table so that composition is a handful of byte shuffles.
+   Entries 26 to 31 always map to themselves. The plugboard, reflector and
+   each rotor at its position are all permutations, so the whole machine at
+   a given state is one too (see Enigma::permutation). */
+class Permutation {
+ public:
+    Permutation(); // Constructor for the identity
+    Permutation(int const map[]); // Constructor from a table of 26 letters
+
+    int operator[](int letter) const
+    { return map_[letter]; }
+    /* Precondition:
+       'letter' is an integer between 0 and 25. */
+    /* Postcondition:
+       The letter 'letter' is mapped to is returned. */
+
+    Permutation then(Permutation const& next) const;
+    /* Postcondition:
+       The permutation which applies this one and then 'next' is returned,
+       i.e. x is mapped to next[(*this)[x]]. */
+
+    Permutation inverse() const;
+    /* Postcondition:
+       The inverse permutation is returned. */
+
+    void substitute(char const input[], char output[], long length) const;
+    /* Precondition:
+       The first 'length' characters of 'input' are letters A - Z.
+       'output' may be 'input'. */
+    /* Postcondition:
+       Each letter is replaced by the one it is mapped to, 32 at a time by
+       byte shuffles when the compiler targets them. */
+
+    Permutation conjugate(int offset) const;
+    /* Precondition:
+       'offset' is an integer between 0 and 25. */
+    /* Postcondition:
+       The permutation seen through a rotor turned 'offset' ticks is
+       returned, i.e. x is mapped to (this[(x + offset) % 26] - offset)
+       mod 26. */
+
+    void cycleLengths(std::vector<int>& lengths) const;
+    /* Postcondition:
+       'lengths' holds the length of every cycle, longest first. */
+
+    void cycles(std::vector<std::vector<int> >& cycles) const;
+    /* Postcondition:
+       'cycles' holds every cycle in order of its smallest letter, each one
+       starting from that letter. */
+
+    bool operator==(Permutation const& other) const;
+    bool operator!=(Permutation const& other) const;
+
+    static Permutation shift(int offset);
+    /* Precondition:
+       'offset' is an integer between 0 and 25. */
+    /* Postcondition:
+       The permutation x -> (x + offset) mod 26 is returned. */
+
+ private:
+    alignas(32) unsigned char map_[32];
+};
+
+
+#endif
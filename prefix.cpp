@@ -0,0 +1,251 @@
+/* Keystream prefix cache member functions
+ *
+ * This file contains the definitions for the member functions of the
+ * keystream prefix cache.
+ */
+
+#include "prefix.h"
+#include "enigma.h"
+#include "permutation.h"
+#include "rotor.h"
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+
+static long packState(int const positions[], int no_of_rotors)
+{
+    long state = 0;
+
+    for (int i = 0; i < no_of_rotors; i++)
+        state = state * 26 + positions[i];
+
+    return state;
+}
+
+
+static void unpackState(long state, int positions[], int no_of_rotors)
+{
+    for (int i = no_of_rotors - 1; i >= 0; i--, state /= 26)
+        positions[i] = state % 26;
+}
+
+
+static string configIdentity(Enigma<> const& machine)
+{
+    string config;
+    Permutation plugboard = machine.plugboard();
+    Permutation reflector = machine.reflector();
+
+    for (int i = 0; i < 26; i++)
+        config += char(plugboard[i]);
+    for (int i = 0; i < 26; i++)
+        config += char(reflector[i]);
+    for (int r = 0; r < machine.rotorCount(); r++) {
+        Rotor rotor(machine.rotor(r));
+        Permutation wiring = rotor.permutation(0);
+        for (int i = 0; i < 26; i++) {
+            rotor.setPosition(i);
+            config += char(wiring[i]);
+            config += char(rotor.atNotch());
+        }
+    }
+
+    return config;
+} // Everything configHash() hashes, so equal strings mean equal machines
+
+
+PrefixCache::PrefixCache(long capacity)
+    : capacity_(capacity), size_(0), hits_(0), misses_(0), evictions_(0)
+{
+}
+
+
+void PrefixCache::encrypt
+(Enigma<>& machine, char const input[], char output[], long length, int& err)
+{
+    int n = machine.rotorCount();
+    long valid = 0;
+
+    if (n > MAX_PREFIX_ROTORS) {
+        machine.encrypt(input, output, length, err);
+        return;
+    }
+
+    while (valid < length && input[valid] >= 'A' && input[valid] <= 'Z')
+        valid++;
+    long cached = min(valid, capacity_);
+    if (cached == 0) {
+        machine.encrypt(input, output, length, err);
+        return;
+    } // Nothing to look up, so neither a hit nor a miss
+
+    shared_ptr<Prefix const> prefix = prefixFor(machine, cached);
+    vector<int> positions(n);
+
+    Permutation const* steps = prefix->steps.data();
+    for (long i = 0; i < cached; i++)
+        output[i] = steps[i][input[i] - 'A'] + 'A';
+
+    unpackState(prefix->states[cached - 1], positions.data(), n);
+    machine.setPositions(positions.data());
+    if (cached < length)
+        machine.encrypt(input + cached, output + cached, length - cached, err);
+    // The uncached rest, or the invalid character with the usual message
+}
+
+
+void PrefixCache::encrypt
+(Enigma<> const& machine, char const input[], char output[], long length,
+ int& err)
+{
+    long valid = 0;
+
+    while (valid < length && input[valid] >= 'A' && input[valid] <= 'Z')
+        valid++;
+
+    if (machine.rotorCount() > MAX_PREFIX_ROTORS || valid < length ||
+        length > capacity_) {
+        Enigma<> copy(machine);
+        encrypt(copy, input, output, length, err);
+        return;
+    } // Only a message the cache serves whole can leave the machine as is
+    if (length == 0)
+        return;
+
+    Permutation const* steps = prefixFor(machine, length)->steps.data();
+    for (long i = 0; i < length; i++)
+        output[i] = steps[i][input[i] - 'A'] + 'A';
+}
+
+
+shared_ptr<PrefixCache::Prefix const> PrefixCache::prefixFor
+(Enigma<> const& machine, long cached)
+{
+    int n = machine.rotorCount();
+    vector<int> positions(n);
+
+    machine.getPositions(positions.data());
+    Key key(machine.configHash(), packState(positions.data(), n));
+    string config = configIdentity(machine);
+    shared_ptr<Prefix const> prefix = find(key, config);
+
+    if (prefix && long(prefix->steps.size()) >= cached)
+        hits_++;
+    else {
+        misses_++;
+        long target = max(cached, MIN_PREFIX);
+        if (prefix)
+            target = max<long>(target, 2 * prefix->steps.size());
+        // Doubled, so a key whose messages keep growing is extended rarely
+        prefix = extend(machine, prefix.get(), min(target, capacity_));
+        insert(key, config, prefix);
+    }
+
+    return prefix;
+}
+
+
+long PrefixCache::hits() const
+{
+    return hits_;
+}
+
+
+long PrefixCache::misses() const
+{
+    return misses_;
+}
+
+
+long PrefixCache::evictions() const
+{
+    return evictions_;
+}
+
+
+long PrefixCache::size() const
+{
+    lock_guard<mutex> hold(lock_);
+
+    return size_;
+}
+
+
+shared_ptr<PrefixCache::Prefix const> PrefixCache::find
+(Key const& key, string const& config)
+{
+    lock_guard<mutex> hold(lock_);
+    auto found = entries_.find(key);
+
+    if (found == entries_.end() || found->second.config != config)
+        return nullptr;
+
+    order_.splice(order_.begin(), order_, found->second.used);
+    return found->second.prefix;
+}
+
+
+void PrefixCache::insert
+(Key const& key, string const& config, shared_ptr<Prefix const> prefix)
+{
+    lock_guard<mutex> hold(lock_);
+    auto found = entries_.find(key);
+
+    if (found != entries_.end()) {
+        Entry& entry = found->second;
+        if (entry.config == config &&
+            entry.prefix->steps.size() >= prefix->steps.size())
+            return; // Another thread got there first
+        size_ -= entry.prefix->steps.size();
+        entry.prefix = prefix;
+        entry.config = config;
+        order_.splice(order_.begin(), order_, entry.used);
+    } else {
+        order_.push_front(key);
+        Entry entry = {prefix, config, order_.begin()};
+        entries_[key] = entry;
+    }
+    size_ += prefix->steps.size();
+
+    while (size_ > capacity_ && order_.size() > 1) {
+        auto oldest = entries_.find(order_.back());
+        size_ -= oldest->second.prefix->steps.size();
+        entries_.erase(oldest);
+        order_.pop_back();
+        evictions_++;
+    }
+}
+
+
+shared_ptr<PrefixCache::Prefix const> PrefixCache::extend
+(Enigma<> const& start, Prefix const* old, long target) const
+{
+    shared_ptr<Prefix> grown = make_shared<Prefix>();
+    Enigma<> walk(start);
+    int n = start.rotorCount();
+    vector<int> positions(n);
+
+    if (old) {
+        *grown = *old;
+        if (!old->states.empty()) {
+            unpackState(old->states.back(), positions.data(), n);
+            walk.setPositions(positions.data());
+        }
+    }
+    grown->steps.reserve(target);
+    grown->states.reserve(target);
+
+    while (long(grown->steps.size()) < target) {
+        walk.seek(1);
+        walk.getPositions(positions.data());
+        grown->steps.push_back(walk.permutation());
+        grown->states.push_back(packState(positions.data(), n));
+    }
+
+    return grown;
+}
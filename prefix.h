@@ -0,0 +1,132 @@
+/* Keystream prefix cache header file
+ *
+ * This file contains the header file for the keystream prefix cache, which
+ * lets messages sent under the same key share the work of stepping the
+ * machine.
+ */
+
+#ifndef PREFIX_H
+#define PREFIX_H
+
+#include "enigma.h"
+#include "permutation.h"
+#include <atomic>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+long const PREFIX_CACHE_STEPS = 1L << 16; // Default bound, about 2.5 MB
+long const MIN_PREFIX = 256; // Steps a prefix is extended by, at least
+int const MAX_PREFIX_ROTORS = 13; // So a rotor state fits in a long
+
+
+/* The 'PrefixCache' class holds, for each key seen recently, the start of
+   the keystream it generates: the substitution for each key press, and the
+   rotor positions after it. A key is the machine's configHash() with its
+   start positions. Each prefix also keeps the whole configuration it was
+   made from, so machines whose hashes collide never share one. A message
+   under a cached key costs one table lookup per letter. A longer message
+   extends the prefix, and the least recently used prefixes are dropped
+   once the cache holds more than its bound of steps. Prefixes are never
+   changed once made, so threads keep using one while another thread
+   replaces or drops it. One cache may be shared by any number of
+   threads. */
+class PrefixCache {
+ public:
+    PrefixCache(long capacity = PREFIX_CACHE_STEPS); // Constructor
+
+    void encrypt
+        (Enigma<>& machine, char const input[], char output[], long length,
+         int& err);
+    /* Precondition:
+       As for Enigma::encrypt. */
+    /* Postcondition:
+       As for Enigma::encrypt, through the cache. Only the first 'capacity'
+       letters of a message are cached; the rest are encrypted by the
+       machine. Machines of more than MAX_PREFIX_ROTORS rotors are not
+       cached. */
+
+    void encrypt
+        (Enigma<> const& machine, char const input[], char output[],
+         long length, int& err);
+    /* Precondition:
+       As for Enigma::encrypt. */
+    /* Postcondition:
+       As above, from the machine's positions but leaving it unchanged. The
+       machine is only copied for letters the cache cannot serve, so a
+       machine shared between threads can be used as it stands. */
+
+    long hits() const;
+    long misses() const;
+    long evictions() const;
+    /* Postcondition:
+       The number of messages served wholly from the cache, the number
+       which had to extend or make a prefix, and the number of prefixes
+       dropped to stay within the bound are returned. */
+
+    long size() const;
+    /* Postcondition:
+       The number of steps held is returned. */
+
+ private:
+    struct Prefix {
+        std::vector<Permutation> steps;
+        std::vector<long> states; // Positions after each step, base 26
+    };
+    typedef std::pair<unsigned long, long> Key; // Config hash, positions
+    typedef std::list<Key> Order; // Most recently used first
+
+    struct Entry {
+        std::shared_ptr<Prefix const> prefix;
+        std::string config; // The configIdentity the prefix was made from
+        Order::iterator used;
+    };
+
+    long capacity_;
+    long size_;
+    mutable std::mutex lock_;
+    std::map<Key, Entry> entries_;
+    Order order_;
+    std::atomic<long> hits_;
+    std::atomic<long> misses_;
+    std::atomic<long> evictions_;
+
+    std::shared_ptr<Prefix const> prefixFor
+        (Enigma<> const& machine, long cached);
+    /* Precondition:
+       'machine' has at most MAX_PREFIX_ROTORS rotors, and 'cached' is
+       between 1 and the capacity. */
+    /* Postcondition:
+       A prefix of at least 'cached' steps from the machine's positions is
+       returned, made or extended if need be, and the hit or miss counted. */
+
+    std::shared_ptr<Prefix const> find
+        (Key const& key, std::string const& config);
+    /* Postcondition:
+       The prefix for 'key' is returned and marked as most recently used,
+       or null if there is none or it was made from another 'config'. */
+
+    std::shared_ptr<Prefix const> extend
+        (Enigma<> const& start, Prefix const* old, long target) const;
+    /* Precondition:
+       'start' is the machine at the key's start positions, and 'old' is the
+       key's prefix, or null. */
+    /* Postcondition:
+       A new prefix of 'target' steps is returned, copying 'old' and
+       generating the rest from where it ended. */
+
+    void insert
+        (Key const& key, std::string const& config,
+         std::shared_ptr<Prefix const> prefix);
+    /* Postcondition:
+       'prefix' replaces any shorter prefix for 'key', or any made from
+       another 'config', and the least recently used prefixes are dropped
+       until the bound is kept. */
+};
+
+
+#endif
@@ -0,0 +1,106 @@
+/* Live configuration member functions
+ *
+ * This file contains the definitions for member functions to reload the
+ * machine configuration while readers keep using it.
+ */
+
+#include "errors.h"
+#include "reload.h"
+#include "enigma.h"
+#include <atomic>
+#include <iostream>
+#include <sys/stat.h>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+
+LiveConfig::LiveConfig(int argc, char** argv)
+    : current_(nullptr), epoch_(1)
+{
+    argc_ = argc;
+    argv_ = argv;
+
+    for (int i = 0; i < MAX_READERS; i++)
+        slots_[i].epoch = 0;
+}
+
+
+LiveConfig::~LiveConfig()
+{
+    delete current_.load();
+}
+
+
+void LiveConfig::load(int& err)
+{
+    modifiedTimes(mtimes_);
+    // Taken before parsing, so a change made during the parse is seen by
+    // the next call to 'changed'. Invalid files are not retried until they
+    // change again.
+
+    Enigma<>* fresh = new Enigma<>(argc_ - 4);
+    fresh->setConfig(argc_, argv_, err);
+    if (err) {
+        delete fresh;
+        cerr << "Configuration not loaded (error code " << err;
+        cerr << "); keeping the previous one.\n";
+        return;
+    }
+
+    Enigma<> const* old = current_.exchange(fresh);
+    unsigned long epoch = ++epoch_;
+
+    for (int i = 0; i < MAX_READERS; i++) {
+        unsigned long entered;
+        while ( (entered = slots_[i].epoch.load()) && entered < epoch )
+            this_thread::yield();
+        // A reader from an older epoch may still hold 'old'
+    }
+
+    delete old;
+    err = NO_ERROR;
+}
+
+
+bool LiveConfig::changed() const
+{
+    vector<timespec> mtimes;
+    modifiedTimes(mtimes);
+
+    for (size_t i = 0; i < mtimes.size(); i++) {
+        if (i >= mtimes_.size() || mtimes[i].tv_sec != mtimes_[i].tv_sec
+            || mtimes[i].tv_nsec != mtimes_[i].tv_nsec)
+            return true;
+    }
+
+    return false;
+}
+
+
+Enigma<> const* LiveConfig::enter(int reader)
+{
+    slots_[reader].epoch.store(epoch_.load());
+    return current_.load();
+}
+
+
+void LiveConfig::leave(int reader)
+{
+    slots_[reader].epoch.store(0);
+}
+
+
+void LiveConfig::modifiedTimes(vector<timespec>& mtimes) const
+{
+    struct stat info;
+
+    mtimes.clear();
+    for (int i = 1; i < argc_; i++) {
+        if (stat(argv_[i], &info))
+            mtimes.push_back(timespec());
+        else
+            mtimes.push_back(info.st_mtim);
+    }
+}
@@ -0,0 +1,80 @@
+/* Live configuration header file
+ *
+ * This file contains the header file for the live configuration class, which
+ * lets a long running program reload its machine configuration.
+ */
+
+#ifndef RELOAD_H
+#define RELOAD_H
+
+#include "enigma.h"
+#include <atomic>
+#include <ctime>
+#include <vector>
+
+int const MAX_READERS = 64; // Threads which may hold the configuration at once
+
+
+/* The 'LiveConfig' class holds the current machine configuration, read from
+   the files named on the command line, and swaps in a new one when 'load' is
+   called again. Readers never lock: each has a slot in which it records the
+   reload epoch it entered in, read-copy-update style. A reload parses and
+   validates the files first, publishes the new machine with one atomic
+   exchange, and then waits for every reader still in an older epoch to
+   leave before freeing the old machine. If the files are invalid, the old
+   machine stays in place. 'load' must only be called from one thread. */
+class LiveConfig {
+ public:
+    LiveConfig(int argc, char** argv); // Constructor
+    ~LiveConfig(); // Destructor
+
+    void load(int& err);
+    /* Precondition:
+       'err' is the error code, currently set to 0. */
+    /* Postcondition:
+       If the configuration files are invalid, the error code is changed
+       and the previous machine, if any, stays current. Otherwise, the new
+       machine is current, the previous one has been freed once no reader
+       held it, and err = 0. */
+
+    bool changed() const;
+    /* Postcondition:
+       True is returned if any configuration file has been modified since
+       the last 'load', false otherwise. */
+
+    Enigma<> const* enter(int reader);
+    /* Precondition:
+       'reader' is an integer between 0 and MAX_READERS - 1 used by no other
+       thread, and the reader is not already entered. */
+    /* Postcondition:
+       The current machine is returned. It stays valid until 'leave'. */
+
+    void leave(int reader);
+    /* Precondition:
+       'reader' has entered. */
+    /* Postcondition:
+       The machine returned by 'enter' may now be freed by a reload. */
+
+ private:
+    struct alignas(64) Slot {
+        std::atomic<unsigned long> epoch; // 0 when not entered
+    };
+    // One cache line each, so readers do not slow each other down
+
+    int argc_;
+    char** argv_;
+    std::atomic<Enigma<> const*> current_;
+    std::atomic<unsigned long> epoch_;
+    Slot slots_[MAX_READERS];
+    std::vector<std::timespec> mtimes_; // Of each file at the last load
+
+    void modifiedTimes(std::vector<std::timespec>& mtimes) const;
+    /* Postcondition:
+       'mtimes' holds the modification time of each configuration file, or
+       zero for a file which cannot be read. */
+
+    LiveConfig(LiveConfig const&); // Not copyable
+};
+
+
+#endif
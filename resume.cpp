@@ -0,0 +1,254 @@
+/* Resumable encryption functions
+ *
+ * This file contains the definitions for functions to encrypt very large
+ * files with checkpoints.
+ */
+
+#include "errors.h"
+#include "resume.h"
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+
+unsigned long const FNV_OFFSET = 14695981039346656037UL;
+unsigned long const FNV_PRIME = 1099511628211UL;
+
+
+static unsigned long checksum
+(unsigned long sum, char const data[], long length)
+{
+    for (long i = 0; i < length; i++)
+        sum = (sum ^ (unsigned char) data[i]) * FNV_PRIME;
+
+    return sum;
+}
+
+
+static bool writeAll(int fd, char const data[], long length)
+{
+    long n;
+
+    while (length > 0 && (n = write(fd, data, length)) > 0) {
+        data += n;
+        length -= n;
+    }
+
+    return length == 0;
+}
+
+
+bool saveCheckpoint(string const& name, Checkpoint const& checkpoint)
+{
+    string temp_name = name + ".tmp";
+    ostringstream text;
+
+    text << "encrypt-checkpoint " << checkpoint.config_hash << '\n';
+    text << "input " << checkpoint.input_offset << ' ';
+    text << checkpoint.input_size << ' ' << checkpoint.input_sum << '\n';
+    text << "output " << checkpoint.output_offset << ' ';
+    text << checkpoint.output_sum << '\n';
+    text << "positions";
+    for (int position : checkpoint.positions)
+        text << ' ' << position;
+    text << '\n';
+
+    string data = text.str();
+    int fd = open(temp_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return false;
+    bool written = writeAll(fd, data.data(), data.size()) && !fsync(fd);
+    // On disk before the rename makes it the checkpoint
+
+    return !close(fd) && written && !rename(temp_name.c_str(), name.c_str());
+}
+
+
+bool loadCheckpoint(string const& name, Checkpoint& checkpoint)
+{
+    ifstream in(name);
+    string word;
+    int position;
+
+    if (!(in >> word) || word != "encrypt-checkpoint")
+        return false;
+    in >> checkpoint.config_hash;
+    in >> word >> checkpoint.input_offset >> checkpoint.input_size;
+    in >> checkpoint.input_sum;
+    in >> word >> checkpoint.output_offset >> checkpoint.output_sum;
+    in >> word;
+
+    checkpoint.positions.clear();
+    while (in >> position)
+        checkpoint.positions.push_back(position);
+
+    return in.eof() && word == "positions";
+}
+
+
+static bool prefixMatches(int fd, long length, unsigned long expected)
+{
+    vector<char> data(RESUME_CHUNK);
+    unsigned long sum = FNV_OFFSET;
+    long done = 0, n;
+
+    while (done < length &&
+           (n = pread(fd, data.data(), min(RESUME_CHUNK, length - done),
+                      done)) > 0) {
+        sum = checksum(sum, data.data(), n);
+        done += n;
+    }
+
+    return done == length && sum == expected;
+}
+
+
+static bool resumable
+(Checkpoint const& checkpoint, Enigma<> const& machine, long input_size,
+ int input_fd, int output_fd)
+{
+    struct stat info;
+
+    if (checkpoint.config_hash != machine.configHash() ||
+        checkpoint.input_size != input_size ||
+        checkpoint.input_offset < 0 || checkpoint.input_offset > input_size ||
+        int(checkpoint.positions.size()) != machine.rotorCount() ||
+        fstat(output_fd, &info) || info.st_size < checkpoint.output_offset)
+        return false;
+
+    for (int position : checkpoint.positions) {
+        if (position < 0 || position > 25)
+            return false;
+    }
+
+    return prefixMatches(input_fd, checkpoint.input_offset,
+                         checkpoint.input_sum) &&
+           prefixMatches(output_fd, checkpoint.output_offset,
+                         checkpoint.output_sum);
+} // The input is reread too, as one edited in place keeps its size
+
+
+void encryptFile
+(Enigma<>& machine, EngineSelector& engines, string const& input,
+ string const& output, string const& checkpoint_name, double interval,
+ int& err)
+{
+    int input_fd = open(input.c_str(), O_RDONLY);
+    int output_fd = open(output.c_str(), O_RDWR | O_CREAT, 0644);
+    struct stat info;
+
+    if (input_fd < 0 || output_fd < 0 || fstat(input_fd, &info)) {
+        cerr << "Error opening '" << (input_fd < 0 ? input : output);
+        cerr << "'.\n";
+        err = ERROR_OPENING_CONFIGURATION_FILE;
+        if (input_fd >= 0)
+            close(input_fd);
+        if (output_fd >= 0)
+            close(output_fd);
+        return;
+    }
+
+    Checkpoint checkpoint;
+    checkpoint.config_hash = machine.configHash();
+    checkpoint.input_size = info.st_size;
+    checkpoint.input_offset = checkpoint.output_offset = 0;
+    checkpoint.input_sum = checkpoint.output_sum = FNV_OFFSET;
+    checkpoint.positions.resize(machine.rotorCount());
+
+    ifstream existing(checkpoint_name);
+    if (existing.good()) {
+        existing.close();
+        if (!loadCheckpoint(checkpoint_name, checkpoint) ||
+            !resumable(checkpoint, machine, info.st_size, input_fd,
+                       output_fd)) {
+            cerr << "Checkpoint '" << checkpoint_name << "' does not match ";
+            cerr << "the input, configuration or output. Remove it to ";
+            cerr << "start again.\n";
+            err = ERROR_OPENING_CONFIGURATION_FILE;
+            close(input_fd);
+            close(output_fd);
+            return;
+        }
+        machine.setPositions(checkpoint.positions.data());
+        cerr << "Resuming at byte " << checkpoint.input_offset << " of ";
+        cerr << checkpoint.input_size << ".\n";
+    }
+    // Anything written after the checkpoint is cut off and done again
+    if (ftruncate(output_fd, checkpoint.output_offset) ||
+        lseek(output_fd, checkpoint.output_offset, SEEK_SET) < 0 ||
+        lseek(input_fd, checkpoint.input_offset, SEEK_SET) < 0)
+        err = ERROR_OPENING_CONFIGURATION_FILE;
+
+    vector<char> text(RESUME_CHUNK), ciphertext(RESUME_CHUNK);
+    auto last_save = chrono::steady_clock::now();
+    bool finished = false;
+    long n;
+
+    while (!err && !finished &&
+           (n = read(input_fd, text.data(), RESUME_CHUNK)) > 0) {
+        long letters = 0, used = 0;
+        while (used < n && text[used] != '.')
+            used++;
+        finished = used < n;
+        unsigned long input_sum =
+            checksum(checkpoint.input_sum, text.data(), used);
+        for (long i = 0; i < used; i++) {
+            if (!isspace((unsigned char) text[i]))
+                text[letters++] = text[i];
+        } // Read as the main program reads, so the same files give the
+          // same text
+
+        long valid = 0;
+        while (valid < letters && text[valid] >= 'A' && text[valid] <= 'Z')
+            valid++;
+        engines.encrypt(machine, text.data(), ciphertext.data(), letters, err);
+        if (err)
+            letters = valid; // Written, as by the main program, but the
+                             // last checkpoint stays where it was
+
+        if (!writeAll(output_fd, ciphertext.data(), letters)) {
+            cerr << "Error writing '" << output << "'.\n";
+            err = ERROR_OPENING_CONFIGURATION_FILE;
+            break;
+        }
+        checkpoint.output_sum = checksum(checkpoint.output_sum,
+                                         ciphertext.data(), letters);
+        checkpoint.output_offset += letters;
+        checkpoint.input_offset += used;
+        checkpoint.input_sum = input_sum;
+
+        chrono::duration<double> since =
+            chrono::steady_clock::now() - last_save;
+        if (err || finished || since.count() < interval)
+            continue;
+
+        machine.getPositions(checkpoint.positions.data());
+        if (fdatasync(output_fd) ||
+            !saveCheckpoint(checkpoint_name, checkpoint))
+            cerr << "Could not write checkpoint '" << checkpoint_name
+                 << "'.\n";
+        last_save = chrono::steady_clock::now();
+    }
+    if (!err && !finished && checkpoint.input_offset < checkpoint.input_size) {
+        cerr << "Error reading '" << input << "'.\n";
+        err = ERROR_OPENING_CONFIGURATION_FILE;
+    } // Otherwise the input ran out without a '.', which also ends it
+
+    if (!err) { // Stopped by a '.' or the end of the input
+        if (!writeAll(output_fd, "\n", 1) || fdatasync(output_fd)) {
+            cerr << "Error writing '" << output << "'.\n";
+            err = ERROR_OPENING_CONFIGURATION_FILE;
+        } else
+            remove(checkpoint_name.c_str());
+    }
+    close(input_fd);
+    close(output_fd);
+}
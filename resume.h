@@ -0,0 +1,67 @@
+/* Resumable encryption header file
+ *
+ * This file contains the header file for encrypting very large files with
+ * checkpoints, so that a run which is stopped can carry on where it left
+ * off.
+ */
+
+#ifndef RESUME_H
+#define RESUME_H
+
+#include "enigma.h"
+#include "engine.h"
+#include <string>
+#include <vector>
+
+long const RESUME_CHUNK = 1L << 20; // Bytes of input read at a time
+double const CHECKPOINT_SECONDS = 10; // Between checkpoints, by default
+
+
+/* 'Checkpoint' records how far an encryption has got. The output up to
+   'output_offset' has been flushed to disk before the checkpoint naming it
+   is written, and its checksum lets a restart confirm the output file still
+   holds it. The input file's size and a checksum of the input read so far,
+   with the configuration hash, make sure the run is resumed on the same
+   input and machine. */
+struct Checkpoint {
+    unsigned long config_hash;
+    long input_size;
+    long input_offset; // Bytes of input read, whitespace included
+    unsigned long input_sum; // FNV-1a of those bytes
+    long output_offset; // Letters of ciphertext written
+    unsigned long output_sum; // FNV-1a of those letters
+    std::vector<int> positions; // Of the rotors after the last letter
+};
+
+
+bool saveCheckpoint(std::string const& name, Checkpoint const& checkpoint);
+/* Postcondition:
+   The checkpoint is written to a temporary file, flushed to disk and
+   renamed over 'name', so 'name' always holds a whole checkpoint. True is
+   returned on success. */
+
+bool loadCheckpoint(std::string const& name, Checkpoint& checkpoint);
+/* Postcondition:
+   If 'name' holds a checkpoint, it is read into 'checkpoint' and true is
+   returned. Otherwise false is returned. */
+
+void encryptFile
+    (Enigma<>& machine, EngineSelector& engines, std::string const& input,
+     std::string const& output, std::string const& checkpoint,
+     double interval, int& err);
+/* Precondition:
+   'machine' is configured at its start positions, and 'err' is the error
+   code, currently set to 0. */
+/* Postcondition:
+   'input' is encrypted into 'output' as the main program would, skipping
+   whitespace and stopping at a '.', a chunk at a time with the engine
+   'engines' picks. A checkpoint is saved after a chunk whenever 'interval'
+   seconds have passed since the last one. If 'checkpoint' already exists
+   and matches the input, machine and output file, the output is cut back
+   to its offset and the run carries on from there; if it does not match,
+   an error message is displayed and the error code changed. The checkpoint
+   is removed once the whole input is done. An invalid character stops the
+   run as it stops Enigma::encrypt, leaving the last checkpoint as it was. */
+
+
+#endif
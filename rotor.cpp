@@ -32,6 +32,7 @@ Rotor::Rotor(Rotor const& rotor)
         
         notches_[i] = rotor.notches_[i];
     }
+    wiring_ = rotor.wiring_;
 }
 
 
@@ -54,6 +55,25 @@ void Rotor::setMappings(ifstream& rot_file, int& err, char const filename[])
         mappings_[i][0] = mapping; // mappings_[][0] for right-to-left,
         mappings_[mapping][1] = i; // and mappings_[][1] for left-to-right
     }
+
+    int wiring[26];
+    for (int i = 0; i < 26; i++)
+        wiring[i] = mappings_[i][0];
+    wiring_ = Permutation(wiring);
+}
+
+
+void Rotor::load(char const filename[], int& err)
+{
+    ifstream rot_file(filename);
+    if ( (err = fileReadErr(filename, rot_file)) )
+        return;
+
+    setMappings(rot_file, err, filename);
+    if (err)
+        return;
+
+    setNotches(rot_file, err, filename);
 }
 
 
@@ -108,6 +128,42 @@ bool Rotor::turn()
 }
 
 
+bool Rotor::atNotch() const
+{
+    return notches_[pos_];
+}
+
+
+bool Rotor::atTurnover() const
+{
+    return notches_[(pos_ + 1) % 26];
+}
+
+
+int Rotor::position() const
+{
+    return pos_;
+}
+
+
+void Rotor::setPosition(int position)
+{
+    pos_ = position;
+}
+
+
+Permutation Rotor::permutation() const
+{
+    return wiring_.conjugate(pos_);
+}
+
+
+Permutation Rotor::permutation(int position) const
+{
+    return wiring_.conjugate(position);
+}
+
+
 int Rotor::inputRtoL(int letter)
 {
     letter = (letter + pos_) % 26;
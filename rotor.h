@@ -9,6 +9,7 @@
 #ifndef ROTOR_H
 #define ROTOR_H
 
+#include "permutation.h"
 #include <fstream>
 
 
@@ -26,6 +27,44 @@ class Rotor {
     /* Postcondition:
        'pos_' is incremented by 1 (mod 26). If the rotor moves into a position
        where a notch exists, true is returned. Otherwise, false is returned. */
+
+    bool atNotch() const;
+    /* Precondition:
+       'pos_' is currently an integer between 0 and 25. */
+    /* Postcondition:
+       True is returned if the rotor is resting on a notch, false otherwise. */
+
+    bool atTurnover() const;
+    /* Precondition:
+       'pos_' is currently an integer between 0 and 25. */
+    /* Postcondition:
+       True is returned if the next turn moves the rotor onto a notch, so
+       would carry, false otherwise. */
+
+    int position() const;
+    /* Postcondition:
+       'pos_' is returned. */
+
+    void setPosition(int position);
+    /* Precondition:
+       'position' is an integer between 0 and 25. */
+    /* Postcondition:
+       'pos_' is set to 'position'. */
+
+    Permutation permutation() const;
+    /* Precondition:
+       The rotor mappings are set. */
+    /* Postcondition:
+       The right to left mapping at the current position is returned. Its
+       inverse is the left to right mapping. */
+
+    Permutation permutation(int position) const;
+    /* Precondition:
+       The rotor mappings are set, and 'position' is an integer between 0
+       and 25. */
+    /* Postcondition:
+       The right to left mapping the rotor would have at 'position' is
+       returned. */
     
     int inputRtoL(int letter);
     /* Precondition:
@@ -74,10 +113,20 @@ class Rotor {
        error code changed. If not, 'rot_file' reads in exactly 26 numbers, the
        rotor mappings are set, and err = 0. */
     
+    void load(char const filename[], int& err);
+    /* Precondition:
+       'filename' is the name of a .rot file, and 'err' is the error code
+       currently set to 0. */
+    /* Postcondition:
+       If an error is encountered, the function immediately returns with the
+       error code changed. Otherwise, the rotor mappings and notches are set
+       from the file, and err = 0. */
+
  private:  
     int mappings_[26][2]; // [0] is right to left, [1] is left to right
     int pos_; // Increments by 1 every time the rotor rotates once
     bool notches_[26]; // notches_[x] true <=> there is a notch at pos x
+    Permutation wiring_; // mappings_[][0] at position 0
     
     int invalidRotor
         (int n, int i, std::ifstream& input, char const filename[]) const;
@@ -0,0 +1,154 @@
+/* Trial decryption scoring member functions
+ *
+ * This file contains the definitions for member functions to train the
+ * bigram scorer and to keep the table of best candidates.
+ */
+
+#include "errors.h"
+#include "scorer.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+using namespace std;
+
+
+Scorer::Scorer()
+{
+    for (int i = 0; i < 27; i++) {
+        for (int j = 0; j < 26; j++)
+            log_probs_[i][j] = log(1.0 / 26);
+    }
+    best_step_ = mean_step_ = log(1.0 / 26);
+    sd_step_ = 0;
+    confidence_ = 0;
+}
+
+
+void Scorer::train(istream& ins, int& err)
+{
+    long counts[27][26] = {};
+    vector<int> letters;
+    int prev = START;
+    char ch;
+
+    while (ins.get(ch)) {
+        if (!isalpha((unsigned char) ch))
+            continue; // Plaintext is sent without spaces or punctuation
+        int next = toupper((unsigned char) ch) - 'A';
+        if (prev != START)
+            counts[prev][next]++;
+        counts[START][next]++;
+        // The first-letter row is filled with single letter counts, since
+        // a training text has too few first letters to learn from
+        prev = next;
+        letters.push_back(next);
+    }
+
+    if (letters.empty()) {
+        cerr << "\nTraining text contains no letters.\n";
+        err = INVALID_INPUT_CHARACTER;
+        return;
+    }
+
+    best_step_ = -numeric_limits<double>::infinity();
+    for (int i = 0; i < 27; i++) {
+        long total = 26; // Add-one smoothing
+        for (int j = 0; j < 26; j++)
+            total += counts[i][j];
+        for (int j = 0; j < 26; j++) {
+            log_probs_[i][j] = log(double(counts[i][j] + 1) / total);
+            best_step_ = max(best_step_, log_probs_[i][j]);
+        }
+    }
+
+    double sum = 0, sum_sq = 0;
+    prev = START;
+    for (int next : letters) {
+        sum += step(prev, next);
+        sum_sq += step(prev, next) * step(prev, next);
+        prev = next;
+    }
+    mean_step_ = sum / letters.size();
+    sd_step_ = sqrt(max(0.0, sum_sq / letters.size() - mean_step_ * mean_step_));
+
+    err = NO_ERROR;
+}
+
+
+void Scorer::setConfidence(double confidence)
+{
+    confidence_ = confidence;
+}
+
+
+bool trialDecrypt
+(Enigma<>& machine, int const text[], long length, Scorer const& scorer,
+ double threshold, double& score, TrialStats& stats)
+{
+    int prev = Scorer::START, err = NO_ERROR;
+
+    stats.candidates++;
+    score = 0;
+
+    for (long i = 0; i < length; i++) {
+        char in = 'A' + text[i], out;
+        machine.encrypt(&in, &out, 1, err); // Always a letter, so no error
+        int key = out - 'A';
+        score += scorer.step(prev, key);
+        prev = key;
+
+        if (score + scorer.bound(length - 1 - i) < threshold) {
+            // Even the best expected remainder could not reach it
+            stats.rejected++;
+            stats.rejected_letters += i + 1;
+            return false;
+        }
+    }
+
+    stats.completed_letters += length;
+    return true;
+}
+
+
+TopK::TopK(int k)
+{
+    k_ = k;
+}
+
+
+double TopK::threshold() const
+{
+    if (heap_.empty() || int(heap_.size()) < k_)
+        return -numeric_limits<double>::infinity();
+
+    return heap_.front().first;
+}
+
+
+void TopK::offer(double score, long key)
+{
+    typedef pair<double, long> Entry;
+    auto worse = [](Entry const& a, Entry const& b) { return a.first > b.first; };
+
+    if (int(heap_.size()) < k_) {
+        heap_.push_back(Entry(score, key));
+        push_heap(heap_.begin(), heap_.end(), worse);
+    } else if (k_ > 0 && score > heap_.front().first) {
+        pop_heap(heap_.begin(), heap_.end(), worse);
+        heap_.back() = Entry(score, key);
+        push_heap(heap_.begin(), heap_.end(), worse);
+    }
+}
+
+
+vector<pair<double, long> > TopK::results() const
+{
+    vector<pair<double, long> > sorted(heap_);
+
+    sort(sorted.rbegin(), sorted.rend());
+    return sorted;
+}
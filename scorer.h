@@ -0,0 +1,127 @@
+/* Trial decryption scoring header file
+ *
+ * This file contains the header file for the bigram scorer, the top-K table
+ * of best candidates, and the statistics kept during trial decryption.
+ */
+
+#ifndef SCORER_H
+#define SCORER_H
+
+#include "enigma.h"
+#include <algorithm>
+#include <cmath>
+#include <istream>
+#include <utility>
+#include <vector>
+
+
+/* The 'Scorer' class holds bigram log-probabilities learnt from a training
+   text. A decryption is scored one letter at a time, so a trial can be
+   abandoned part way through (see trialDecrypt). */
+class Scorer {
+ public:
+    Scorer(); // Constructor
+
+    void train(std::istream& ins, int& err);
+    /* Precondition:
+       'ins' is the input stream holding the training text, and 'err' is
+       the error code, currently set to 0. */
+    /* Postcondition:
+       Every letter up to eof is counted (case is ignored and all other
+       characters skipped), the log-probabilities are set with add-one
+       smoothing, and err = 0. If the text has no letters, an error message
+       is displayed and the error code changed. */
+
+    double step(int prev, int next) const
+    { return log_probs_[prev][next]; }
+    /* Precondition:
+       'prev' is the previous letter, or START for the first letter, and
+       'next' is an integer between 0 and 25. */
+    /* Postcondition:
+       The log-probability of 'next' following 'prev' is returned. */
+
+    double bound(long remaining) const
+    {
+        double exact = remaining * best_step_;
+        if (confidence_ <= 0)
+            return exact;
+        return std::min(exact, remaining * mean_step_ +
+                        confidence_ * sd_step_ * std::sqrt(double(remaining)));
+    }
+    /* Precondition:
+       'remaining' is the number of letters still to be scored. */
+    /* Postcondition:
+       The most the score is expected to rise over the remaining letters is
+       returned. With no confidence set this is exact: every letter scores
+       at most the best bigram. Otherwise it is the training text's mean
+       plus 'confidence' standard deviations, which is far tighter but may
+       rarely prune the right key. */
+
+    void setConfidence(double confidence);
+    /* Postcondition:
+       'bound' uses 'confidence' standard deviations above the mean, or the
+       exact bound if 'confidence' is 0 or less. */
+
+    static int const START = 26; // 'prev' value for the first letter
+
+ private:
+    double log_probs_[27][26]; // Row 26 holds the first-letter probabilities
+    double best_step_; // Largest entry in 'log_probs_'
+    double mean_step_; // Mean and standard deviation of a step over
+    double sd_step_;   // the training text
+    double confidence_;
+};
+
+
+/* 'TrialStats' counts how much work trial decryption did. */
+struct TrialStats {
+    long candidates = 0; // Number of trials started
+    long rejected = 0; // Trials abandoned early
+    long rejected_letters = 0; // Letters decrypted by abandoned trials
+    long completed_letters = 0; // Letters decrypted by completed trials
+};
+
+
+bool trialDecrypt
+    (Enigma<>& machine, int const text[], long length, Scorer const& scorer,
+     double threshold, double& score, TrialStats& stats);
+/* Precondition:
+   'text' holds 'length' letters as integers between 0 and 25, and the
+   rotors of 'machine' are set to the candidate start positions. */
+/* Postcondition:
+   The text is decrypted one letter at a time while its score is kept.
+   As soon as the score can no longer reach 'threshold', even if the
+   remaining letters rise by 'scorer.bound()', the trial is abandoned and
+   false returned. Otherwise 'score' holds the final score and true is
+   returned. 'stats' is updated either way. */
+
+
+/* The 'TopK' class keeps the best 'k' scores seen so far, with the key each
+   belongs to. Its threshold is the score a new candidate has to beat. */
+class TopK {
+ public:
+    TopK(int k); // Constructor
+
+    double threshold() const;
+    /* Postcondition:
+       The lowest score in the table is returned if it is full, otherwise
+       minus infinity, as it is for a table of no entries. */
+
+    void offer(double score, long key);
+    /* Precondition:
+       'score' is the final score of candidate 'key'. */
+    /* Postcondition:
+       If the score beats the threshold, the candidate is added to the table,
+       dropping the lowest entry if the table was full. */
+
+    std::vector<std::pair<double, long> > results() const;
+    /* Postcondition:
+       The entries are returned, best score first. */
+
+ private:
+    std::vector<std::pair<double, long> > heap_; // Min-heap on score
+    int k_;
+};
+
+
+#endif
@@ -0,0 +1,157 @@
+/* Distributed key search program
+ * 
+ * This file contains the main program for a key search over every rotor
+ * order and start position, split between worker processes. Usage:
+ * './search coordinate [-t <lease seconds>] <address> <checkpoint>
+ *  <training text> <ciphertext> <plugboard> <reflector> <rotorI>...<rotorx>'
+ * './search work <address> <training text> <ciphertext> <plugboard>
+ *  <reflector> <rotorI>...<rotorx>'
+ * The address is a Unix socket path or "host:port". Workers must be given
+ * the same files, in the same order, as the coordinator, which turns away
+ * any worker given others. Any number
+ * of workers may join or leave while the search runs; the coordinator
+ * prints the best keys once every rotor order has been searched. */
+
+#include "errors.h"
+#include "enigma.h"
+#include "enumerator.h"
+#include "fidelis.h"
+#include "scorer.h"
+#include "search.h"
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <signal.h>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+
+int coordinate(int argc, char** argv)
+{
+    double lease_seconds = 60;
+    int err = NO_ERROR;
+    vector<int> orders;
+
+    if (argc > 3 && string(argv[2]) == "-t") {
+        lease_seconds = atof(argv[3]);
+        argc -= 2;
+        argv += 2;
+    }
+    if (argc < 8 + SEARCH_ROTORS) {
+        cerr << "At least " << SEARCH_ROTORS << " rotors must be given.\n";
+        return INSUFFICIENT_NUMBER_OF_PARAMETERS;
+    }
+
+    unsigned long identity = searchIdentity(argv + 4, argc - 4, err);
+    if (err)
+        return err;
+    rotorOrders(argc - 8, SEARCH_ROTORS, orders);
+    Coordinator coordinator(orders.size() / SEARCH_ROTORS, identity,
+                            lease_seconds, argv[3]);
+    coordinator.resume(err);
+    if (err)
+        return err;
+
+    int listen_fd = listenOn(argv[2], err);
+    if (err)
+        return err;
+    coordinator.serve(listen_fd);
+
+    for (auto const& entry : coordinator.best().results()) {
+        long order = entry.second / SEARCH_POSITIONS;
+        long key = entry.second % SEARCH_POSITIONS;
+        for (int i = 0; i < SEARCH_ROTORS; i++)
+            cout << argv[8 + orders[order * SEARCH_ROTORS + i]] << ' ';
+        cout << ' ' << key / 676 << ' ' << key / 26 % 26 << ' ' << key % 26;
+        cout << "  score " << entry.first << '\n';
+    }
+
+    return NO_ERROR;
+}
+
+
+int work(int argc, char** argv)
+{
+    int err = NO_ERROR;
+
+    if (argc < 7 + SEARCH_ROTORS) {
+        cerr << "At least " << SEARCH_ROTORS << " rotors must be given.\n";
+        return INSUFFICIENT_NUMBER_OF_PARAMETERS;
+    }
+
+    Scorer scorer;
+    ifstream training(argv[3]);
+    if ( (err = fileReadErr(argv[3], training)) )
+        return err;
+    scorer.train(training, err);
+    if (err)
+        return err;
+
+    vector<int> text;
+    ifstream ct_file(argv[4]);
+    if ( (err = fileReadErr(argv[4], ct_file)) )
+        return err;
+    char ch;
+    ct_file >> ws >> ch;
+    while (ch != '.' && !ct_file.eof()) {
+        if (ch < 'A' || ch > 'Z') {
+            cerr << "\n'" << ch << "' is not a valid ciphertext character.\n";
+            return INVALID_INPUT_CHARACTER;
+        }
+        text.push_back(ch - 'A');
+        ct_file >> ws >> ch;
+    }
+
+    Enigma<> base(SEARCH_ROTORS);
+    char* config[3] = {argv[0], argv[5], argv[6]};
+    base.setConfig(3, config, err); // Plugboard and reflector only
+    if (err)
+        return err;
+
+    vector<Rotor> library(argc - 7);
+    for (int i = 7; i < argc; i++) {
+        library[i-7].load(argv[i], err);
+        if (err)
+            return err;
+    }
+
+    unsigned long identity = searchIdentity(argv + 3, argc - 3, err);
+    if (err)
+        return err;
+    int leases = runWorker(argv[2], identity, base, library, text, scorer);
+    cerr << "Worker finished after " << leases << " leases.\n";
+
+    return NO_ERROR;
+}
+
+
+int main(int argc, char** argv)
+{
+    int err = NO_ERROR;
+    string mode = (argc > 1) ? argv[1] : "";
+
+    signal(SIGPIPE, SIG_IGN); // A vanished peer shows up as a failed write
+
+    if (mode == "coordinate" && argc >= 8)
+        err = coordinate(argc, argv);
+    else if (mode == "work" && argc >= 7)
+        err = work(argc, argv);
+    else {
+        cerr << "Too few command line parameters given.\n";
+        cerr << "'./search coordinate [-t <lease seconds>] <address> ";
+        cerr << "<checkpoint> <training text> <ciphertext> <plugboard> ";
+        cerr << "<reflector> <rotorI>...<rotorx>'\n";
+        cerr << "'./search work <address> <training text> <ciphertext> ";
+        cerr << "<plugboard> <reflector> <rotorI>...<rotorx>'\n\n";
+        err = INSUFFICIENT_NUMBER_OF_PARAMETERS;
+    }
+
+    if (err) {
+        cerr << "Error code " << err << ". Exiting...\n";
+        return err;
+    }
+
+    return NO_ERROR;
+}
@@ -0,0 +1,428 @@
+/* Distributed key search functions
+ *
+ * This file contains the definitions for the socket helpers, the
+ * coordinator's member functions and the worker loop.
+ */
+
+#include "errors.h"
+#include "search.h"
+#include "enumerator.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sstream>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+
+int const REQUEST_TIMEOUT = 5; // Seconds a connection may take to send
+int const CONNECT_RETRIES = 3;
+unsigned long const FNV_OFFSET = 14695981039346656037UL;
+unsigned long const FNV_PRIME = 1099511628211UL;
+
+
+static int openSocket(string const& address, bool listening)
+{
+    size_t colon = address.rfind(':');
+    int fd = -1;
+
+    if (colon == string::npos) {
+        sockaddr_un unix_addr;
+        memset(&unix_addr, 0, sizeof(unix_addr));
+        unix_addr.sun_family = AF_UNIX;
+        if (address.size() >= sizeof(unix_addr.sun_path))
+            return -1;
+        strcpy(unix_addr.sun_path, address.c_str());
+
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listening)
+            unlink(address.c_str()); // Left behind by an earlier run
+        sockaddr const* addr = (sockaddr const*) &unix_addr;
+        if (fd >= 0 && (listening ? bind(fd, addr, sizeof(unix_addr))
+                                  : connect(fd, addr, sizeof(unix_addr)))) {
+            close(fd);
+            fd = -1;
+        }
+        return fd;
+    }
+
+    addrinfo hints, *found;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = listening ? AI_PASSIVE : 0;
+    string host = address.substr(0, colon), port = address.substr(colon + 1);
+    if (getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(),
+                    &hints, &found))
+        return -1;
+
+    for (addrinfo* ai = found; ai && fd < 0; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        int yes = 1;
+        if (fd >= 0 && listening)
+            setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+        if (fd >= 0 && (listening ? bind(fd, ai->ai_addr, ai->ai_addrlen)
+                                  : connect(fd, ai->ai_addr, ai->ai_addrlen))) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(found);
+
+    return fd;
+}
+
+
+int listenOn(string const& address, int& err)
+{
+    int fd = openSocket(address, true);
+
+    if (fd < 0 || listen(fd, 64)) {
+        cerr << "Error listening on '" << address << "': ";
+        cerr << strerror(errno) << ".\n";
+        err = ERROR_OPENING_CONFIGURATION_FILE;
+        if (fd >= 0)
+            close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+
+int connectTo(string const& address)
+{
+    return openSocket(address, false);
+}
+
+
+static bool readLine(int fd, string& line)
+{
+    char ch;
+
+    line.clear();
+    while (read(fd, &ch, 1) == 1) {
+        if (ch == '\n')
+            return true;
+        line += ch;
+    }
+
+    return false; // Connection closed or timed out mid line
+}
+
+
+static bool writeAll(int fd, string const& text)
+{
+    size_t sent = 0;
+
+    while (sent < text.size()) {
+        ssize_t n = write(fd, text.data() + sent, text.size() - sent);
+        if (n <= 0)
+            return false;
+        sent += n;
+    }
+
+    return true;
+}
+
+
+unsigned long searchIdentity(char* const files[], int count, int& err)
+{
+    unsigned long hash = FNV_OFFSET;
+    char buffer[1 << 16];
+
+    for (int i = 0; i < count; i++) {
+        ifstream in(files[i], ios::binary);
+        long size = 0;
+        while (in.read(buffer, sizeof(buffer)) || in.gcount() > 0) {
+            for (long j = 0; j < in.gcount(); j++)
+                hash = (hash ^ (unsigned char) buffer[j]) * FNV_PRIME;
+            size += in.gcount();
+        }
+        if (in.bad() || !in.eof()) {
+            cerr << "Error opening '" << files[i] << "'.\n";
+            err = ERROR_OPENING_CONFIGURATION_FILE;
+            return 0;
+        }
+        for (int shift = 0; shift < 64; shift += 8)
+            hash = (hash ^ ((size >> shift) & 0xff)) * FNV_PRIME;
+        // Each file's length ends it, so moving bytes between files changes
+        // the hash
+    }
+
+    return hash;
+}
+
+
+Coordinator::Coordinator
+(int no_of_orders, unsigned long identity, double lease_seconds,
+ char const checkpoint[])
+    : best_(SEARCH_TOP_K)
+{
+    Lease fresh = {false, 0};
+
+    leases_.assign(no_of_orders, fresh);
+    remaining_ = no_of_orders;
+    identity_ = identity;
+    lease_seconds_ = lease_seconds;
+    checkpoint_ = checkpoint;
+}
+
+
+void Coordinator::resume(int& err)
+{
+    ifstream in(checkpoint_);
+    string word;
+    int no_of_orders;
+    unsigned long identity;
+
+    if (in.fail())
+        return; // No checkpoint, so a fresh search
+
+    if (!(in >> word >> no_of_orders >> identity) ||
+        word != "search-checkpoint" || no_of_orders != int(leases_.size()) ||
+        identity != identity_) {
+        cerr << "Checkpoint '" << checkpoint_ << "' is for a different ";
+        cerr << "search. Remove it to start again.\n";
+        err = ERROR_OPENING_CONFIGURATION_FILE;
+        return;
+    }
+
+    while (in >> word) {
+        if (word == "done") {
+            int order;
+            in >> order;
+            if (order >= 0 && order < int(leases_.size()) &&
+                !leases_[order].done) {
+                leases_[order].done = true;
+                remaining_--;
+            }
+        } else if (word == "result") {
+            double score;
+            long key;
+            in >> score >> key;
+            best_.offer(score, key);
+        }
+    }
+
+    cerr << "Resumed from '" << checkpoint_ << "': " << remaining_;
+    cerr << " of " << leases_.size() << " rotor orders left.\n";
+}
+
+
+void Coordinator::serve(int listen_fd)
+{
+    pollfd waiting = {listen_fd, POLLIN, 0};
+
+    while (remaining_ > 0) {
+        if (poll(&waiting, 1, 1000) <= 0)
+            continue;
+
+        int fd = accept(listen_fd, nullptr, nullptr);
+        if (fd < 0)
+            continue;
+
+        timeval timeout = {REQUEST_TIMEOUT, 0};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        // A worker which stalls mid request cannot hold up the others
+        handle(fd);
+        close(fd);
+    }
+}
+
+
+TopK const& Coordinator::best() const
+{
+    return best_;
+}
+
+
+void Coordinator::handle(int fd)
+{
+    string line, command;
+
+    if (!readLine(fd, line))
+        return;
+    stringstream request(line);
+    request >> command;
+
+    if (command == "LEASE") {
+        unsigned long identity;
+        if (!(request >> identity) || identity != identity_) {
+            writeAll(fd, "ERROR\n");
+            return; // A worker given other files
+        }
+
+        time_t now = time(nullptr);
+        int order = 0;
+        while (order < int(leases_.size()) &&
+               (leases_[order].done || leases_[order].expires > now))
+            order++;
+        // Unleased orders have expires == 0, so are always picked up
+
+        char reply[64];
+        if (order < int(leases_.size())) {
+            leases_[order].expires = now + (time_t) lease_seconds_;
+            snprintf(reply, sizeof(reply), "LEASE %d %.17g\n",
+                     order, best_.threshold());
+        } else
+            snprintf(reply, sizeof(reply), remaining_ ? "WAIT\n" : "DONE\n");
+        writeAll(fd, reply);
+    } else if (command == "RESULT") {
+        int order, count;
+        vector<pair<double, long> > results;
+        if (!(request >> order >> count) || count < 0) {
+            writeAll(fd, "ERROR\n");
+            return; // Malformed, so the lease stays outstanding
+        }
+
+        for (int i = 0; i < count; i++) {
+            if (!readLine(fd, line))
+                return; // Incomplete, so the lease stays outstanding
+            stringstream entry(line);
+            double score;
+            long key;
+            if (!(entry >> score >> key)) {
+                writeAll(fd, "ERROR\n");
+                return;
+            }
+            results.push_back(make_pair(score, key));
+        }
+
+        if (order >= 0 && order < int(leases_.size()) &&
+            !leases_[order].done) {
+            // A late duplicate from an expired lease is ignored
+            for (auto const& result : results)
+                best_.offer(result.first, result.second);
+            leases_[order].done = true;
+            remaining_--;
+            save();
+        }
+        writeAll(fd, "OK\n");
+    }
+}
+
+
+void Coordinator::save() const
+{
+    string temp_name = checkpoint_ + ".tmp";
+    ostringstream text;
+
+    text.precision(17);
+    text << "search-checkpoint " << leases_.size() << ' ' << identity_;
+    text << '\n';
+    for (size_t order = 0; order < leases_.size(); order++) {
+        if (leases_[order].done)
+            text << "done " << order << '\n';
+    }
+    for (auto const& entry : best_.results())
+        text << "result " << entry.first << ' ' << entry.second << '\n';
+
+    int fd = open(temp_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    bool written = fd >= 0 && writeAll(fd, text.str()) && !fsync(fd);
+    // On disk before the rename makes it the checkpoint
+    if (fd >= 0 && close(fd))
+        written = false;
+
+    if (!written || rename(temp_name.c_str(), checkpoint_.c_str()))
+        cerr << "Could not write checkpoint '" << checkpoint_ << "'.\n";
+}
+
+
+static bool request(string const& address, string const& text, int& fd)
+{
+    for (int attempt = 0; attempt < CONNECT_RETRIES; attempt++) {
+        fd = connectTo(address);
+        if (fd >= 0) {
+            if (writeAll(fd, text))
+                return true;
+            close(fd);
+        }
+        sleep(1);
+    }
+
+    return false;
+}
+
+
+int runWorker
+(string const& address, unsigned long identity, Enigma<> const& base,
+ vector<Rotor> const& library, vector<int> const& text, Scorer const& scorer)
+{
+    vector<int> orders;
+    Enigma<> machine(base);
+    int leases = 0, fd;
+    string line, reply;
+
+    rotorOrders(library.size(), SEARCH_ROTORS, orders);
+
+    int no_of_orders = orders.size() / SEARCH_ROTORS;
+    string lease_request = "LEASE " + to_string(identity) + "\n";
+
+    while (request(address, lease_request, fd)) {
+        bool got = readLine(fd, line);
+        close(fd);
+        stringstream lease(line);
+        lease >> reply;
+
+        if (!got || reply == "DONE")
+            break;
+        if (reply == "WAIT") {
+            sleep(1); // Every order is leased; one may yet expire
+            continue;
+        }
+
+        int order;
+        string bound;
+        if (reply != "LEASE" || !(lease >> order >> bound) || order < 0 ||
+            order >= no_of_orders) {
+            cerr << "The coordinator sent '" << line << "'; it is searching ";
+            cerr << "with other files, or a different library.\n";
+            break;
+        }
+        double threshold = strtod(bound.c_str(), nullptr);
+        // Parsed by hand, since >> does not read "-inf"
+
+        for (int i = 0; i < SEARCH_ROTORS; i++)
+            machine.setRotor(i, library[orders[order * SEARCH_ROTORS + i]]);
+
+        KeyEnumerator keys(machine);
+        TopK best(SEARCH_TOP_K);
+        TrialStats stats;
+        double score;
+        for (keys.seek(0); keys.key() < keys.size(); keys.next()) {
+            machine.setPositions(keys.positions());
+            double bar = max(threshold, best.threshold());
+            if (trialDecrypt(machine, text.data(), text.size(), scorer, bar,
+                             score, stats))
+                best.offer(score, (long) order * SEARCH_POSITIONS + keys.key());
+        }
+
+        stringstream result;
+        result.precision(17);
+        vector<pair<double, long> > entries = best.results();
+        result << "RESULT " << order << ' ' << entries.size() << '\n';
+        for (auto const& entry : entries)
+            result << entry.first << ' ' << entry.second << '\n';
+
+        if (!request(address, result.str(), fd))
+            break;
+        readLine(fd, line); // "OK"
+        close(fd);
+        leases++;
+    }
+
+    return leases;
+}
@@ -0,0 +1,134 @@
+/* Distributed key search header file
+ *
+ * This file contains the header file for the coordinator and workers of a
+ * key search split across processes.
+ */
+
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include "enigma.h"
+#include "rotor.h"
+#include "scorer.h"
+#include <ctime>
+#include <string>
+#include <vector>
+
+int const SEARCH_ROTORS = 3; // Rotors in the machine, chosen from the library
+int const SEARCH_POSITIONS = 26 * 26 * 26; // Start positions per rotor order
+int const SEARCH_TOP_K = 10;
+
+
+/* The search runs over every rotor order from the library and every start
+   position. A key is (order * SEARCH_POSITIONS + start positions), and one
+   rotor order is leased to a worker at a time. Workers and the coordinator
+   talk over a Unix socket (any address without a ':') or TCP ("host:port"),
+   one request per connection, in lines of text:
+
+     LEASE <identity>       -> LEASE <order> <threshold> | WAIT | DONE
+                               | ERROR
+     RESULT <order> <n>     -> OK | ERROR
+     followed by n lines of "<score> <key>"
+
+   The identity is a hash of the files the search was started with (see
+   searchIdentity), so a worker given other files gets ERROR instead of a
+   lease. A malformed result gets ERROR and leaves its lease outstanding.
+
+   A lease not reported within its time limit is handed out again, so a
+   lost worker only costs one lease. The coordinator saves the finished
+   orders and its top-K table to a checkpoint after every result, so a
+   killed search resumes where it stopped. The checkpoint records the
+   identity too, and is only resumed by the same search. */
+
+
+int listenOn(std::string const& address, int& err);
+/* Precondition:
+   'err' is the error code, currently set to 0. */
+/* Postcondition:
+   A listening socket is returned. If it cannot be set up, an error message
+   is displayed, the error code changed and -1 returned. */
+
+unsigned long searchIdentity(char* const files[], int count, int& err);
+/* Precondition:
+   'files' names the training text, ciphertext, plugboard, reflector and
+   rotor library, in that order, and 'err' is the error code, currently
+   set to 0. */
+/* Postcondition:
+   A hash of the contents of every file, in order, is returned. If a file
+   cannot be read, an error message is displayed and the error code
+   changed. */
+
+int connectTo(std::string const& address);
+/* Postcondition:
+   A socket connected to 'address' is returned, or -1 on failure. */
+
+
+/* The 'Coordinator' class hands out leases and merges the results. */
+class Coordinator {
+ public:
+    Coordinator
+        (int no_of_orders, unsigned long identity, double lease_seconds,
+         char const checkpoint[]);
+    // Constructor
+
+    void resume(int& err);
+    /* Precondition:
+       'err' is the error code, currently set to 0. */
+    /* Postcondition:
+       If the checkpoint file exists, its finished orders and results are
+       restored. If it belongs to a search of a different size or
+       identity, an error message is displayed and the error code
+       changed. */
+
+    void serve(int listen_fd);
+    /* Precondition:
+       'listen_fd' is a listening socket. */
+    /* Postcondition:
+       Requests are answered until every order is finished. */
+
+    TopK const& best() const;
+    /* Postcondition:
+       The merged top-K table is returned. */
+
+ private:
+    struct Lease {
+        bool done;
+        std::time_t expires; // 0 if never handed out
+    };
+
+    std::vector<Lease> leases_;
+    unsigned long identity_;
+    int remaining_; // Orders not yet finished
+    double lease_seconds_;
+    std::string checkpoint_;
+    TopK best_;
+
+    void handle(int fd);
+    /* Precondition:
+       'fd' is a newly accepted connection. */
+    /* Postcondition:
+       One request is read and answered. */
+
+    void save() const;
+    /* Postcondition:
+       The checkpoint is written to a temporary file, synced, and renamed
+       over the old one, so it is never left half written. */
+};
+
+
+int runWorker
+    (std::string const& address, unsigned long identity,
+     Enigma<> const& base, std::vector<Rotor> const& library,
+     std::vector<int> const& text, Scorer const& scorer);
+/* Precondition:
+   'base' has its plugboard and reflector set and room for SEARCH_ROTORS
+   rotors, 'library' holds the same rotors the coordinator was given, and
+   'text' is the ciphertext as integers between 0 and 25. 'identity' is
+   the searchIdentity of the worker's files. */
+/* Postcondition:
+   Leases are taken, searched and reported until the coordinator has none
+   left, cannot be reached, or refuses the worker's files. The number of
+   leases searched is returned. */
+
+
+#endif
@@ -0,0 +1,178 @@
+/* Encryption service program
+ *
+ * This file contains the main program for the long running encryption
+ * service. Usage:
+ * './serve <plugboard> <reflector> <rotorI> <rotorII>...<rotorx> <rotor pos>'
+ * Each line read in is a message, encrypted from the configured start
+ * positions and written out as one line, in the order read. Messages are
+ * encrypted on all hardware threads. The configuration is reloaded on
+ * SIGHUP, or when one of its files changes, without pausing messages.
+ * Keystreams are cached by configuration and start positions, so messages
+ * under a key already seen cost a table lookup per letter. */
+
+#include "errors.h"
+#include "enigma.h"
+#include "reload.h"
+#include "prefix.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <signal.h>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+int const QUEUED_PER_READER = 4; // Lines read ahead of the readers, each
+
+
+/* 'Messages' hands the lines read in to the reader threads, and writes
+   their replies out in the order the lines were read. */
+struct Messages {
+    mutex lock;
+    condition_variable ready; // A line is waiting, or input has ended
+    condition_variable space; // The queue has room for another line
+    deque<pair<long, string> > pending; // Numbered in the order read
+    map<long, string> replies; // Finished out of order, awaiting output
+    long next_reply = 0;
+    size_t limit = 1;
+    bool closed = false;
+};
+
+
+void reloader(LiveConfig& config, atomic<bool>& done)
+{
+    sigset_t hangup;
+    timespec poll_interval = {1, 0}; // Checks file times once a second
+    int err;
+
+    sigemptyset(&hangup);
+    sigaddset(&hangup, SIGHUP);
+
+    while (!done) {
+        bool signalled =
+            sigtimedwait(&hangup, nullptr, &poll_interval) == SIGHUP;
+        if (signalled || config.changed()) {
+            err = NO_ERROR;
+            config.load(err);
+            if (!err)
+                cerr << "Configuration reloaded.\n";
+        }
+    }
+}
+
+
+void reader
+(int slot, LiveConfig& config, PrefixCache& cache, Messages& messages,
+ ostream& outs)
+{
+    pair<long, string> job;
+    vector<char> output;
+
+    for (;;) {
+        {
+            unique_lock<mutex> hold(messages.lock);
+            messages.ready.wait(hold, [&] {
+                return !messages.pending.empty() || messages.closed; });
+            if (messages.pending.empty())
+                return;
+            job = move(messages.pending.front());
+            messages.pending.pop_front();
+        }
+        messages.space.notify_one();
+
+        string const& line = job.second;
+        int err = NO_ERROR;
+        output.resize(line.size());
+        Enigma<> const* machine = config.enter(slot);
+        cache.encrypt(*machine, line.data(), output.data(), line.size(), err);
+        config.leave(slot);
+        // Used in place, from its configured start positions; a reload
+        // frees it only once this reader has left
+
+        string reply = err ? "Error code " + to_string(err) + "."
+                           : string(output.begin(), output.end());
+
+        lock_guard<mutex> hold(messages.lock);
+        messages.replies[job.first] = move(reply);
+        auto next = messages.replies.begin();
+        if (next->first != messages.next_reply)
+            continue; // An earlier line's reader will write this one out
+        while (next != messages.replies.end() &&
+               next->first == messages.next_reply) {
+            outs << next->second << '\n';
+            next = messages.replies.erase(next);
+            messages.next_reply++;
+        }
+        outs.flush();
+    }
+}
+
+
+int main(int argc, char** argv)
+{
+    int err = NO_ERROR;
+    LiveConfig config(argc, argv);
+
+    sigset_t hangup;
+    sigemptyset(&hangup);
+    sigaddset(&hangup, SIGHUP);
+    pthread_sigmask(SIG_BLOCK, &hangup, nullptr);
+    // Blocked before the first load and in every thread, so only the
+    // reloader's sigtimedwait takes it, once there is a machine to replace
+
+    ostream outs(cout.rdbuf());
+    cout.rdbuf(cerr.rdbuf());
+    // Messages from loading the files go to stderr through cout; replies
+    // go to stdout through 'outs' alone
+
+    config.load(err);
+    if (err) {
+        cerr << "Error code " << err << ". Exiting...\n";
+        return err;
+    }
+
+    atomic<bool> done(false);
+    thread reload_thread(reloader, ref(config), ref(done));
+
+    PrefixCache cache;
+    Messages messages;
+    int no_of_readers = min<int>(MAX_READERS,
+                                 max(1u, thread::hardware_concurrency()));
+    messages.limit = QUEUED_PER_READER * no_of_readers;
+    vector<thread> readers;
+    for (int slot = 0; slot < no_of_readers; slot++)
+        readers.push_back(thread(reader, slot, ref(config), ref(cache),
+                                 ref(messages), ref(outs)));
+
+    string line;
+    for (long number = 0; getline(cin, line); number++) {
+        unique_lock<mutex> hold(messages.lock);
+        messages.space.wait(hold, [&] {
+            return messages.pending.size() < messages.limit; });
+        messages.pending.push_back(make_pair(number, move(line)));
+        hold.unlock();
+        messages.ready.notify_one();
+    }
+    {
+        lock_guard<mutex> hold(messages.lock);
+        messages.closed = true;
+    }
+    messages.ready.notify_all();
+    for (thread& t : readers)
+        t.join();
+
+    done = true;
+    reload_thread.join();
+    cerr << "Keystream cache: " << cache.hits() << " hits, ";
+    cerr << cache.misses() << " misses, " << cache.evictions();
+    cerr << " evictions.\n";
+
+    return NO_ERROR;
+}
@@ -0,0 +1,276 @@
+/* Session store member functions
+ *
+ * This file contains the definitions for the member functions of the
+ * session store.
+ */
+
+#include "session.h"
+#include "errors.h"
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using namespace std;
+
+
+static uint64_t mix(uint64_t channel)
+{
+    channel ^= channel >> 30;
+    channel *= 0xbf58476d1ce4e5b9;
+    channel ^= channel >> 27;
+    channel *= 0x94d049bb133111eb;
+    return channel ^ (channel >> 31);
+} // Ids handed out in sequence must still spread over shards and slots
+
+
+SessionStore::SessionStore(long expected_sessions)
+    : next_state_(0), shards_(new Shard[SESSION_SHARDS])
+{
+    long wanted = expected_sessions / SESSION_SHARDS / MAX_SESSION_LOAD + 1;
+    long slots = MIN_SHARD_SLOTS;
+
+    while (slots < wanted)
+        slots *= 2;
+
+    Slot empty = {NO_CHANNEL, 0};
+    for (int i = 0; i < SESSION_SHARDS; i++) {
+        shards_[i].slots.assign(slots, empty);
+        shards_[i].used = 0;
+    }
+}
+
+
+int SessionStore::addWiring(Enigma<> const& machine, int& err)
+{
+    int n = machine.rotorCount();
+    uint64_t states = 1;
+
+    for (int i = 0; i < n && states <= (uint64_t(1) << 32); i++)
+        states *= 26;
+    if (n > MAX_SESSION_ROTORS || next_state_ + states > (uint64_t(1) << 32)) {
+        cerr << "No room left for the states of a machine with " << n;
+        cerr << " rotors.\n";
+        err = INVALID_INDEX;
+        return -1;
+    }
+
+    Wiring wiring = {unique_ptr<Enigma<> const>(new Enigma<>(machine)),
+                     next_state_, states};
+    wirings_.push_back(move(wiring));
+    next_state_ += states;
+
+    return wirings_.size() - 1;
+}
+
+
+void SessionStore::open
+(uint64_t channel, int wiring, int const positions[], int& err)
+{
+    if (channel == NO_CHANNEL || wiring < 0 || wiring >= int(wirings_.size())) {
+        cerr << "There is no wiring " << wiring << ", or the channel id ";
+        cerr << "is reserved.\n";
+        err = INVALID_INDEX;
+        return;
+    }
+
+    Enigma<> const& machine = *wirings_[wiring].machine;
+    int n = machine.rotorCount(), start[MAX_SESSION_ROTORS];
+    if (!positions) {
+        machine.getPositions(start);
+        positions = start;
+    }
+    for (int i = 0; i < n; i++) {
+        if (positions[i] < 0 || positions[i] > 25) {
+            cerr << "Rotor position " << positions[i] << " is out of range.\n";
+            err = INVALID_INDEX;
+            return;
+        }
+    }
+
+    uint64_t hash;
+    Shard& shard = shardOf(channel, hash);
+    lock_guard<mutex> hold(shard.lock);
+    long slot = find(shard, channel, hash);
+
+    if (slot < 0) {
+        if (shard.used + 1 > MAX_SESSION_LOAD * shard.slots.size()) {
+            grow(shard);
+            slot = find(shard, channel, hash);
+        }
+        slot = -1 - slot;
+        shard.slots[slot].channel = channel;
+        shard.used++;
+    }
+    shard.slots[slot].state = pack(wiring, positions);
+}
+
+
+bool SessionStore::close(uint64_t channel)
+{
+    uint64_t hash;
+    Shard& shard = shardOf(channel, hash);
+    lock_guard<mutex> hold(shard.lock);
+    long slot = find(shard, channel, hash);
+
+    if (slot < 0)
+        return false;
+
+    vector<Slot>& slots = shard.slots;
+    size_t mask = slots.size() - 1, hole = slot;
+    for (size_t next = (hole + 1) & mask; slots[next].channel != NO_CHANNEL;
+         next = (next + 1) & mask) {
+        size_t home = mix(slots[next].channel) & mask;
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            slots[hole] = slots[next];
+            hole = next;
+        }
+    } // Shifts back whatever would no longer be found past the hole
+    slots[hole].channel = NO_CHANNEL;
+    shard.used--;
+
+    return true;
+}
+
+
+void SessionStore::encrypt
+(uint64_t channel, char const input[], char output[], long length, int& err)
+{
+    uint64_t hash;
+    Shard& shard = shardOf(channel, hash);
+    lock_guard<mutex> hold(shard.lock);
+    long slot = find(shard, channel, hash);
+
+    if (slot < 0) {
+        cerr << "Channel " << channel << " is not open.\n";
+        err = INVALID_INDEX;
+        return;
+    }
+
+    int positions[MAX_SESSION_ROTORS];
+    int wiring = unpack(shard.slots[slot].state, positions);
+    if (int(shard.machines.size()) <= wiring)
+        shard.machines.resize(wiring + 1);
+    if (!shard.machines[wiring])
+        shard.machines[wiring].reset(new Enigma<>(*wirings_[wiring].machine));
+
+    Enigma<>& machine = *shard.machines[wiring];
+    machine.setPositions(positions);
+    machine.encrypt(input, output, length, err);
+    machine.getPositions(positions);
+    shard.slots[slot].state = pack(wiring, positions);
+}
+
+
+bool SessionStore::state(uint64_t channel, int& wiring, int positions[]) const
+{
+    uint64_t hash;
+    Shard& shard = shardOf(channel, hash);
+    lock_guard<mutex> hold(shard.lock);
+    long slot = find(shard, channel, hash);
+
+    if (slot < 0)
+        return false;
+
+    wiring = unpack(shard.slots[slot].state, positions);
+    return true;
+}
+
+
+long SessionStore::size() const
+{
+    long total = 0;
+
+    for (int i = 0; i < SESSION_SHARDS; i++) {
+        lock_guard<mutex> hold(shards_[i].lock);
+        total += shards_[i].used;
+    }
+
+    return total;
+}
+
+
+long SessionStore::bytes() const
+{
+    long total = SESSION_SHARDS * sizeof(Shard);
+
+    for (int i = 0; i < SESSION_SHARDS; i++) {
+        lock_guard<mutex> hold(shards_[i].lock);
+        total += shards_[i].slots.capacity() * sizeof(Slot);
+    }
+
+    return total;
+}
+
+
+SessionStore::Shard& SessionStore::shardOf
+(uint64_t channel, uint64_t& hash) const
+{
+    hash = mix(channel);
+
+    return shards_[(hash >> 32) % SESSION_SHARDS];
+} // High bits pick the shard and low bits the slot, so they do not collide
+
+
+long SessionStore::find
+(Shard const& shard, uint64_t channel, uint64_t hash) const
+{
+    size_t mask = shard.slots.size() - 1;
+
+    for (size_t slot = hash & mask; ; slot = (slot + 1) & mask) {
+        uint64_t held = shard.slots[slot].channel;
+        if (held == channel)
+            return slot;
+        if (held == NO_CHANNEL)
+            return -1 - long(slot);
+    } // Never full, as the table grows first
+}
+
+
+void SessionStore::grow(Shard& shard)
+{
+    Slot empty = {NO_CHANNEL, 0};
+    vector<Slot> slots(shard.slots.size() * 2, empty);
+    size_t mask = slots.size() - 1;
+
+    for (Slot const& held : shard.slots) {
+        if (held.channel == NO_CHANNEL)
+            continue;
+        size_t slot = mix(held.channel) & mask;
+        while (slots[slot].channel != NO_CHANNEL)
+            slot = (slot + 1) & mask;
+        slots[slot] = held;
+    }
+
+    shard.slots.swap(slots);
+}
+
+
+uint32_t SessionStore::pack(int wiring, int const positions[]) const
+{
+    Wiring const& held = wirings_[wiring];
+    int n = held.machine->rotorCount();
+    uint64_t state = 0;
+
+    for (int i = 0; i < n; i++)
+        state = state * 26 + positions[i];
+
+    return held.first + state;
+}
+
+
+int SessionStore::unpack(uint32_t state, int positions[]) const
+{
+    auto after = upper_bound(wirings_.begin(), wirings_.end(), state,
+                             [](uint64_t state, Wiring const& wiring)
+                             { return state < wiring.first; });
+    int wiring = after - wirings_.begin() - 1;
+    Wiring const& held = wirings_[wiring];
+    uint64_t rest = state - held.first;
+
+    for (int i = held.machine->rotorCount() - 1; i >= 0; i--, rest /= 26)
+        positions[i] = rest % 26;
+
+    return wiring;
+}
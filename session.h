@@ -0,0 +1,132 @@
+/* Session store header file
+ *
+ * This file contains the header file for the session store, which keeps the
+ * rotor state of a very large number of long lived channels between the
+ * chunks of text sent on them.
+ */
+
+#ifndef SESSION_H
+#define SESSION_H
+
+#include "enigma.h"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+int const SESSION_SHARDS = 256; // Each with its own lock
+int const MAX_SESSION_ROTORS = 6; // So that a state fits in 32 bits
+int const MIN_SHARD_SLOTS = 16;
+double const MAX_SESSION_LOAD = 0.8; // Of the slots, before growing
+uint64_t const NO_CHANNEL = ~uint64_t(0); // Marks an empty slot
+
+
+/* The 'SessionStore' class maps channel ids to the state of a machine. The
+   machines themselves, the wirings, are few and shared: each is added once,
+   and is given its own range of a 32 bit state space, one state for each
+   setting of its rotors. A channel is then its id and one state, 12 bytes,
+   held in an open addressing hash table split into SESSION_SHARDS shards,
+   each behind its own lock. A chunk is encrypted under its shard's lock on
+   a copy of the wiring kept by the shard, so chunks on one channel are
+   encrypted in the order they arrive while other shards carry on. */
+class SessionStore {
+ public:
+    SessionStore(long expected_sessions = 0); // Constructor
+
+    int addWiring(Enigma<> const& machine, int& err);
+    /* Precondition:
+       'machine' is a configured machine, and no other thread is using the
+       store. */
+    /* Postcondition:
+       The index of a copy of 'machine' is returned, which sessions may be
+       opened on. If its states would not fit in what is left of the state
+       space, err = INVALID_INDEX and -1 is returned. */
+
+    void open
+        (uint64_t channel, int wiring, int const positions[], int& err);
+    /* Precondition:
+       'positions' holds one position per rotor of the wiring, or is null
+       for the positions the wiring was added at. */
+    /* Postcondition:
+       'channel' is open on 'wiring' at those positions, replacing any
+       state it had. If 'channel' is NO_CHANNEL, the wiring does not exist
+       or a position is out of range, err = INVALID_INDEX and nothing is
+       changed. */
+
+    bool close(uint64_t channel);
+    /* Postcondition:
+       'channel' is forgotten. True is returned if it was open. */
+
+    void encrypt
+        (uint64_t channel, char const input[], char output[], long length,
+         int& err);
+    /* Postcondition:
+       As for Enigma::encrypt, on the channel's machine, which then keeps
+       its new state for the next chunk. If the channel is not open, err =
+       INVALID_INDEX and nothing is encrypted. */
+
+    bool state(uint64_t channel, int& wiring, int positions[]) const;
+    /* Postcondition:
+       If 'channel' is open, its wiring and rotor positions are written and
+       true is returned. Otherwise false is returned. */
+
+    long size() const;
+    /* Postcondition:
+       The number of open channels is returned. */
+
+    long bytes() const;
+    /* Postcondition:
+       The memory held by the hash table is returned, in bytes. */
+
+ private:
+    struct __attribute__((packed)) Slot {
+        uint64_t channel;
+        uint32_t state; // A wiring's first state, plus its packed positions
+    };
+
+    struct alignas(64) Shard {
+        mutable std::mutex lock;
+        std::vector<Slot> slots; // A power of two of them
+        long used;
+        std::vector<std::unique_ptr<Enigma<> > > machines; // By wiring
+    };
+
+    struct Wiring {
+        std::unique_ptr<Enigma<> const> machine;
+        uint64_t first; // State of all rotors at 0
+        uint64_t states;
+    };
+
+    std::vector<Wiring> wirings_;
+    uint64_t next_state_;
+    std::unique_ptr<Shard[]> shards_;
+
+    Shard& shardOf(uint64_t channel, uint64_t& hash) const;
+    /* Postcondition:
+       The shard 'channel' belongs to is returned, and 'hash' is set to
+       pick its slot. */
+
+    long find(Shard const& shard, uint64_t channel, uint64_t hash) const;
+    /* Precondition:
+       The shard is locked. */
+    /* Postcondition:
+       The slot holding 'channel' is returned, or -1 - the empty slot it
+       would go in. */
+
+    void grow(Shard& shard);
+    /* Precondition:
+       The shard is locked. */
+    /* Postcondition:
+       The shard has twice the slots, holding the same channels. */
+
+    uint32_t pack(int wiring, int const positions[]) const;
+    int unpack(uint32_t state, int positions[]) const;
+    /* Postcondition:
+       A state is packed from, or unpacked into, a wiring and the positions
+       of its rotors, leftmost most significant. */
+
+    SessionStore(SessionStore const&); // Not copyable
+};
+
+
+#endif
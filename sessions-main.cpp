@@ -0,0 +1,159 @@
+/* Session multiplexing program
+ *
+ * This file contains the main program for encrypting many channels of text
+ * which each keep their own rotor state. Usage:
+ * './sessions [-n <channels>] <plugboard> <reflector> <rotorI>...<rotorx>
+ *  <rotor pos>'
+ * Each line read in is a channel id followed by a chunk of text for it. A
+ * channel is opened at the configured start positions the first time it is
+ * seen, and the chunk is encrypted from wherever its last chunk left off
+ * and written out after the id. '-n' instead opens that many channels and
+ * sends chunks on each from all hardware threads, and reports the time and
+ * memory taken. */
+
+#include "errors.h"
+#include "enigma.h"
+#include "session.h"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+int const CHUNK = 16; // Letters sent on each channel at a time when timing
+int const ROUNDS = 4; // Chunks sent on each channel when timing
+
+
+int multiplex(SessionStore& store, int wiring)
+{
+    string line, text;
+    unsigned long channel;
+    vector<char> output;
+    int err = NO_ERROR;
+
+    while (getline(cin, line)) {
+        istringstream fields(line);
+        if (!(fields >> channel))
+            continue;
+        text.clear();
+        fields >> text;
+
+        int positions[MAX_SESSION_ROTORS], held;
+        if (!store.state(channel, held, positions))
+            store.open(channel, wiring, nullptr, err);
+
+        output.resize(text.size());
+        if (!err)
+            store.encrypt(channel, text.data(), output.data(), text.size(),
+                          err);
+        if (err) {
+            cout << channel << " Error code " << err << ".\n";
+            err = NO_ERROR;
+        } else {
+            cout << channel << ' ';
+            cout.write(output.data(), output.size()) << '\n';
+        }
+    }
+
+    cerr << store.size() << " channels held in " << store.bytes();
+    cerr << " bytes.\n";
+    return NO_ERROR;
+}
+
+
+int timeChannels(SessionStore& store, int wiring, long channels)
+{
+    unsigned no_of_threads = max(1u, thread::hardware_concurrency());
+    atomic<long> next_channel(0);
+    atomic<int> failed(NO_ERROR);
+    char input[CHUNK];
+
+    for (int i = 0; i < CHUNK; i++)
+        input[i] = 'A' + i;
+
+    auto opener = [&]() {
+        int err = NO_ERROR;
+        for (long i; (i = next_channel++) < channels; )
+            store.open(i, wiring, nullptr, err);
+        if (err)
+            failed = err;
+    };
+    auto sender = [&]() {
+        char output[CHUNK];
+        int err = NO_ERROR;
+        for (long i; (i = next_channel++) < channels * ROUNDS; )
+            store.encrypt(i % channels, input, output, CHUNK, err);
+        if (err)
+            failed = err;
+    }; // Round by round, so each channel's chunks are spread over time
+
+    auto start = chrono::steady_clock::now();
+    vector<thread> threads;
+    for (unsigned t = 1; t < no_of_threads; t++)
+        threads.push_back(thread(opener));
+    opener();
+    for (thread& t : threads)
+        t.join();
+    chrono::duration<double> opening = chrono::steady_clock::now() - start;
+
+    next_channel = 0;
+    threads.clear();
+    start = chrono::steady_clock::now();
+    for (unsigned t = 1; t < no_of_threads; t++)
+        threads.push_back(thread(sender));
+    sender();
+    for (thread& t : threads)
+        t.join();
+    chrono::duration<double> sending = chrono::steady_clock::now() - start;
+
+    if (failed) {
+        cerr << "Error code " << failed << ". Exiting...\n";
+        return failed;
+    }
+
+    long bytes = store.bytes();
+    cerr << store.size() << " channels opened in " << opening.count();
+    cerr << " s, held in " << bytes << " bytes, ";
+    cerr << double(bytes) / channels << " per channel.\n";
+    cerr << channels * ROUNDS << " chunks of " << CHUNK << " letters sent ";
+    cerr << "in " << sending.count() << " s, ";
+    cerr << sending.count() * 1e9 / (channels * ROUNDS) << " ns per chunk.\n";
+    return NO_ERROR;
+}
+
+
+int main(int argc, char** argv)
+{
+    int first = 0, err = NO_ERROR;
+    long channels = 0;
+
+    if (argc > 2 && string(argv[1]) == "-n") {
+        channels = atol(argv[2]);
+        first = 2;
+    } // Shifted so the configuration still starts at argv[first + 1]
+
+    Enigma<> base(argc - first - 4);
+    streambuf* ciphertext = cout.rdbuf(cerr.rdbuf());
+    base.setConfig(argc - first, argv + first, err);
+    cout.rdbuf(ciphertext); // Messages from loading the files go to stderr
+    if (err) {
+        cerr << "Error code " << err << ". Exiting...\n";
+        return err;
+    }
+
+    SessionStore store(channels);
+    int wiring = store.addWiring(base, err);
+    if (err) {
+        cerr << "Error code " << err << ". Exiting...\n";
+        return err;
+    }
+
+    if (channels > 0)
+        return timeChannels(store, wiring, channels);
+    return multiplex(store, wiring);
+}
@@ -0,0 +1,71 @@
+/* Rotor stepping policies
+ *
+ * This file contains the stepping policies which can be plugged into the
+ * Enigma class template. Each policy is a struct with a single static
+ * 'turn' function, so the chosen rule is inlined into the key press loop.
+ * All policies honour every notch set in a rotor, so multi-notch rotors
+ * work with any of them.
+ */
+
+#ifndef STEPPING_H
+#define STEPPING_H
+
+#include "rotor.h"
+
+
+/* 'OdometerStepping' is the original rule: the rightmost rotor turns on every
+   key press, and a rotor which moves onto one of its notches carries the
+   rotor to its left one tick further. */
+struct OdometerStepping {
+    static void turn(Rotor* rotors, int no_of_rotors)
+    {
+        int i = no_of_rotors - 1;
+
+        while (i >= 0 && rotors[i].turn())
+            i--;
+        // (i >= 0) checked first, since rotors[i] may not exist
+    }
+};
+
+
+/* 'DoubleStepping' models the pawl mechanism of the historical machines.
+   The pawls are decided by the positions before the key press: a rotor
+   turns when the rotor to its right is at its turnover, and a rotor with
+   a pawl to its left, i.e. any but the leftmost, also turns when it is at
+   its own turnover. So a middle rotor which has just carried into its
+   turnover moves again at the next press, with the rotor to its left (the
+   historical ADU, ADV, AEW, BFX for rotors I, II and III). */
+struct DoubleStepping {
+    static void turn(Rotor* rotors, int no_of_rotors)
+    {
+        for (int j = 0; j < no_of_rotors - 1; j++) {
+            if (rotors[j + 1].atTurnover() ||
+                (j > 0 && rotors[j].atTurnover()))
+                rotors[j].turn();
+        } // Turning rotor j only changes what decided rotors j - 1 and j
+
+        if (no_of_rotors > 0)
+            rotors[no_of_rotors - 1].turn();
+    }
+};
+
+
+/* 'CogwheelStepping' models machines driven by a gear train instead of
+   pawls. The carry is decided by the positions before the key press: every
+   rotor turns if all the rotors to its right were resting on a notch. */
+struct CogwheelStepping {
+    static void turn(Rotor* rotors, int no_of_rotors)
+    {
+        int i = no_of_rotors - 1;
+
+        while (i > 0 && rotors[i].atNotch())
+            i--;
+        // 'i' is now the leftmost rotor engaged by the gear train
+
+        for (; i >= 0 && i < no_of_rotors; i++)
+            rotors[i].turn();
+    }
+};
+
+
+#endif
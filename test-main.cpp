@@ -0,0 +1,324 @@
+/* Engine test program
+ *
+ * This file contains the known-answer and agreement tests for the machine,
+ * its permutations, the keystream, the encryption engines, the engine
+ * selector and the keystream prefix cache. Usage: './enigma-test', from
+ * the top directory, as the configurations are read from there. Each
+ * failure is described on clog, and the exit status is 1 if there were
+ * any. The machine's own messages are not shown. Run with
+ * tests/regression.sh by 'make test'. */
+
+#include "errors.h"
+#include "enigma.h"
+#include "engine.h"
+#include "keystream.h"
+#include "permutation.h"
+#include "prefix.h"
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+int const AGREEMENT_SEED = 2018;
+long const AGREEMENT_LENGTHS[] = {0, 1, 25, 26, 27, 675, 676, 677, 4096,
+                                  17575, 17576, 17577, 40000};
+// Either side of each carry of a three rotor machine, and past a full cycle
+
+char const* const CONFIGS[] = {
+    "plugboards/null.pb reflectors/II.rf rotors/I.rot rotors/II.rot "
+    "rotors/III.rot rotors/I.pos",
+    "plugboards/I.pb reflectors/I.rf rotors/I.rot rotors/II.rot "
+    "rotors/III.rot rotors/I.pos",
+    "plugboards/II.pb reflectors/II.rf rotors/IV.rot rotors/V.rot "
+    "rotors/VI.rot rotors/VII.rot rotors/VIII.rot tests/five.pos",
+    "plugboards/III.pb reflectors/III.rf rotors/shift_up.rot "
+    "rotors/shift_up.rot rotors/shift_up.rot rotors/II.pos"
+}; // The first is the Enigma I with reflector B, and the last has only
+  // pure shifts, so the substitution engine is usable
+
+int failures = 0;
+
+
+void check(bool passed, string const& what)
+{
+    if (!passed) {
+        clog << "FAILED: " << what << '\n';
+        failures++;
+    }
+}
+
+
+template <class Stepping>
+void configure(Enigma<Stepping>& machine, string const& config)
+{
+    istringstream files(config);
+    vector<string> names(1, "tests");
+    vector<char*> argv;
+    int err = NO_ERROR;
+
+    for (string name; files >> name; )
+        names.push_back(name);
+    for (string& name : names)
+        argv.push_back(&name[0]);
+
+    machine.setConfig(argv.size(), argv.data(), err);
+    check(!err, "loading '" + config + "'");
+}
+
+
+int rotorsIn(string const& config)
+{
+    istringstream files(config);
+    int count = 0;
+
+    for (string name; files >> name; )
+        count++;
+
+    return count - 3; // Less the plugboard, reflector and positions
+}
+
+
+string randomText(unsigned& seed, long length)
+{
+    string text(length, 'A');
+
+    for (char& ch : text) {
+        seed = seed * 1103515245 + 12345;
+        ch = 'A' + (seed >> 16) % 26;
+    }
+
+    return text;
+}
+
+
+string positionsOf(Enigma<> const& machine)
+{
+    vector<int> positions(machine.rotorCount());
+    string text;
+
+    machine.getPositions(positions.data());
+    for (int position : positions)
+        text += to_string(position) + ' ';
+
+    return text;
+}
+
+
+void testPermutation()
+{
+    int wiring[] = {4, 10, 12, 5, 11, 6, 3, 16, 21, 25, 13, 19, 14, 22, 24,
+                    7, 23, 20, 18, 15, 0, 8, 1, 17, 2, 9}; // Rotor I
+    Permutation rotor(wiring), identity;
+    string alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    string output(alphabet.size(), ' ');
+
+    rotor.substitute(alphabet.data(), &output[0], alphabet.size());
+    check(output == "EKMFLGDQVZNTOWYHXUSPAIBRCJEKMFLGDQVZNTOWYHXUSPAIBRCJ",
+          "Permutation::substitute of rotor I");
+    check(rotor.then(rotor.inverse()) == identity &&
+          rotor.inverse().then(rotor) == identity,
+          "Permutation::inverse of rotor I");
+
+    bool conjugates = true;
+    for (int offset = 0; offset < 26; offset++) {
+        Permutation seen = rotor.conjugate(offset);
+        for (int x = 0; x < 26; x++)
+            conjugates = conjugates && seen[x] ==
+                (rotor[(x + offset) % 26] - offset + 26) % 26;
+    }
+    check(conjugates, "Permutation::conjugate of rotor I");
+
+    Enigma<> machine(3);
+    configure(machine, CONFIGS[0]);
+    vector<int> lengths;
+    machine.reflector().cycleLengths(lengths);
+    check(lengths == vector<int>(13, 2), "reflector B is thirteen swaps");
+}
+
+
+void testKnownAnswers()
+{
+    Enigma<> machine(3);
+    char output[6] = {};
+    int err = NO_ERROR;
+
+    configure(machine, CONFIGS[0]);
+    machine.encrypt("AAAAA", output, 5, err);
+    check(!err && string(output) == "BDZGO",
+          "Enigma I, UKW-B, rotors I II III at AAA gives BDZGO");
+
+    for (int i = 0; i < noOfEngines(); i++) {
+        Enigma<> copy(3);
+        configure(copy, CONFIGS[0]);
+        if (engine(i).usable && !engine(i).usable(copy))
+            continue;
+        engine(i).run(copy, "AAAAA", output, 5);
+        check(string(output) == "BDZGO",
+              string("engine '") + engine(i).name + "' gives BDZGO");
+    }
+
+    Enigma<DoubleStepping> pawls(3);
+    configure(pawls, CONFIGS[0]);
+    int start[] = {0, 3, 20}; // ADU
+    pawls.setPositions(start);
+    string seen;
+    for (int press = 0; press < 3; press++) {
+        int positions[3];
+        pawls.seek(1);
+        pawls.getPositions(positions);
+        for (int position : positions)
+            seen += 'A' + position;
+        seen += ' ';
+    }
+    check(seen == "ADV AEW BFX ", "double stepping from ADU gives " + seen);
+}
+
+
+void testKeystream()
+{
+    Enigma<DoubleStepping> machine(3);
+    unsigned seed = AGREEMENT_SEED;
+    int err = NO_ERROR;
+
+    configure(machine, CONFIGS[1]);
+    string text = randomText(seed, 20000);
+    string expected(text.size(), ' '), output(text.size(), ' ');
+
+    Keystream<DoubleStepping> stream(machine);
+    for (size_t i = 0; i < text.size(); i++)
+        output[i] = stream.next()[text[i] - 'A'] + 'A';
+    machine.encrypt(text.data(), &expected[0], text.size(), err);
+    check(!err && output == expected,
+          "Keystream agrees with Enigma under double stepping");
+}
+
+
+void testEngines()
+{
+    unsigned seed = AGREEMENT_SEED;
+
+    for (char const* config : CONFIGS) {
+        Enigma<> base(rotorsIn(config));
+        configure(base, config);
+        vector<int> positions(base.rotorCount());
+
+        for (long length : AGREEMENT_LENGTHS) {
+            for (int& position : positions)
+                position = randomText(seed, 1)[0] - 'A';
+            base.setPositions(positions.data());
+            string text = randomText(seed, length);
+            string expected(length, ' ');
+
+            Enigma<> reference(base);
+            engine(0).run(reference, text.data(), &expected[0], length);
+
+            for (int i = 1; i < noOfEngines(); i++) {
+                if (engine(i).usable && !engine(i).usable(base))
+                    continue;
+                Enigma<> machine(base);
+                string output(length, ' ');
+                engine(i).run(machine, text.data(), &output[0], length);
+                check(output == expected &&
+                      positionsOf(machine) == positionsOf(reference),
+                      string("engine '") + engine(i).name + "' on '" +
+                      config + "', " + to_string(length) + " letters");
+            }
+        }
+    }
+}
+
+
+void testSelector()
+{
+    unsigned seed = AGREEMENT_SEED;
+
+    for (int forced = -1; forced < noOfEngines(); forced++) {
+        EngineSelector engines(forced);
+        for (char const* config : CONFIGS) {
+            Enigma<> base(rotorsIn(config));
+            configure(base, config);
+            for (long length : {100L, 5000L}) {
+                string text = randomText(seed, length);
+                text[length / 2] = 'a'; // Stops both halfway
+                string expected(length, ' '), output(length, ' ');
+                int expected_err = NO_ERROR, err = NO_ERROR;
+
+                Enigma<> reference(base), machine(base);
+                reference.encrypt(text.data(), &expected[0], length,
+                                  expected_err);
+                engines.encrypt(machine, text.data(), &output[0], length,
+                                err);
+                check(err == expected_err &&
+                      output.substr(0, length / 2) ==
+                          expected.substr(0, length / 2) &&
+                      positionsOf(machine) == positionsOf(reference),
+                      "selector forcing " + to_string(forced) + " on '" +
+                      config + "', " + to_string(length) + " letters");
+            }
+        }
+    }
+}
+
+
+void testPrefixCache()
+{
+    unsigned seed = AGREEMENT_SEED;
+    PrefixCache cache(5000);
+    Enigma<> first(3), second(3);
+    int err = NO_ERROR;
+
+    configure(first, CONFIGS[1]);
+    configure(second, CONFIGS[3]);
+
+    for (int message = 0; message < 200; message++) {
+        Enigma<> const& base = message % 2 ? first : second;
+        string text = randomText(seed, message * 37 % 6000);
+        string expected(text.size(), ' '), output(text.size(), ' ');
+
+        Enigma<> reference(base), machine(base);
+        reference.encrypt(text.data(), &expected[0], text.size(), err);
+        string after = positionsOf(reference);
+        if (message % 3)
+            cache.encrypt(machine, text.data(), &output[0], text.size(), err);
+        else {
+            cache.encrypt(base, text.data(), &output[0], text.size(), err);
+            after = positionsOf(base); // Left at its start positions
+        }
+        check(!err && output == expected && positionsOf(machine) == after,
+              "prefix cache message " + to_string(message));
+    } // The same start positions under two configurations, alternately
+
+    long misses = cache.misses(), hits = cache.hits();
+    char output[1];
+    cache.encrypt(first, "", output, 0, err);
+    Enigma<> machine(first);
+    cache.encrypt(machine, "a", output, 1, err);
+    check(err == INVALID_INPUT_CHARACTER, "prefix cache invalid letter");
+    check(cache.misses() == misses && cache.hits() == hits,
+          "a message with no letters is neither a hit nor a miss");
+    check(cache.size() <= 5000, "prefix cache keeps its bound");
+}
+
+
+int main()
+{
+    cout.rdbuf(nullptr);
+    cerr.rdbuf(nullptr);
+    // The machine's messages and calibration logs; failures go to clog
+
+    testPermutation();
+    testKnownAnswers();
+    testKeystream();
+    testEngines();
+    testSelector();
+    testPrefixCache();
+
+    if (failures) {
+        clog << failures << " checks failed.\n";
+        return 1;
+    }
+    clog << "All engine checks passed.\n";
+    return NO_ERROR;
+}
@@ -0,0 +1,170 @@
+#!/bin/bash
+# Regression tests
+#
+# This file contains the command line tests run by 'make test': the known
+# answer kept in io-files, and a case for each fixed bug which shows at the
+# command line. Run from the top directory once the programs are built.
+# Each failure is described on stderr, and the exit status is 1 if there
+# were any.
+
+top=$(pwd)
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+failures=0
+config="plugboards/I.pb reflectors/I.rf rotors/I.rot rotors/II.rot"
+config="$config rotors/III.rot rotors/I.pos"
+absolute="$top/${config// / $top/}" # For runs in the work directory
+
+fail()
+{
+    echo "FAILED: $1" >&2
+    failures=$((failures + 1))
+}
+
+ciphertext()
+{
+    ./enigma "$@" 2>/dev/null | sed -n 's/.*Generating ciphertext: //p'
+}
+
+
+# The original program's known answer, both streams
+./enigma $config < io-files/input.txt > "$work/out" 2> "$work/err"
+cmp -s "$work/out" io-files/output.txt &&
+    cmp -s "$work/err" io-files/error.txt || fail "io-files known answer"
+
+# Double stepping, with reflector B at AAA
+text=$(printf 'AAAAAAAAAAAAAAAAAAAA.' |
+       ciphertext -m double plugboards/null.pb reflectors/II.rf \
+           rotors/I.rot rotors/II.rot rotors/III.rot rotors/I.pos)
+[ "$text" = BDZGOWCXLTKSBTMCDLPB ] || fail "double stepping gave '$text'"
+./enigma -m pawl $config < /dev/null > /dev/null 2>&1
+[ $? -eq 1 ] || fail "an unknown stepping is rejected"
+
+# Invalid cases for one rotor and three, each giving its error code
+for depth in 1 3; do
+    ./generate -s 7 -n 2 -r $depth -x "$work/sheets$depth" 2> /dev/null ||
+        fail "generate -r $depth -x"
+    cd "$work/sheets$depth"
+    while read code input args; do
+        "$top/enigma" $args < $input > /dev/null 2>&1
+        result=$?
+        [ $result -eq $code ] ||
+            fail "$depth rotor case '$args' gave $result, not $code"
+    done < invalid/cases.txt
+    cd "$top"
+done
+
+# A corpus whose last block is a single byte still ends in ".\n"
+./generate -c 4194305 "$work/corpus" 2> /dev/null || fail "generate -c"
+trailer=$(tail -c 2 "$work/corpus/corpus.txt" | od -An -c | tr -d ' ')
+[ $(stat -c %s "$work/corpus/corpus.txt") -eq 4194305 ] &&
+    [ "$trailer" = '.\n' ] || fail "corpus trailer across the last block"
+./generate -c -5 "$work/negative" > /dev/null 2>&1
+[ $? -eq 1 ] || fail "a negative corpus size is rejected"
+
+# Linting a file whose name is not UTF-8 still prints JSON
+mkdir "$work/lint"
+printf 'Q' > "$work/lint/a"$'\xff'"b.rot"
+./lint "$work/lint" > "$work/lint.txt" 2> /dev/null
+grep -q 'a\\u00ffb.rot' "$work/lint.txt" &&
+    ! LC_ALL=C grep -q $'\xff' "$work/lint.txt" || fail "lint escapes bytes"
+
+# A bulk checkpoint only resumes on the input it was made from
+./generate -s 3 -c 3M "$work/bulk" 2> /dev/null
+cd "$work/bulk"
+cp corpus.txt input.txt
+printf 'a' | dd of=input.txt bs=1 seek=2600000 conv=notrunc 2> /dev/null
+"$top/bulk" -i 0 input.txt output.txt check.txt $absolute \
+    > /dev/null 2>&1
+[ $? -eq 2 ] && [ -f check.txt ] || fail "bulk stops at a bad letter"
+cp input.txt edited.txt
+printf 'a' | dd of=edited.txt bs=1 seek=10 conv=notrunc 2> /dev/null
+dd if=corpus.txt of=input.txt bs=1 skip=2600000 seek=2600000 count=1 \
+    conv=notrunc 2> /dev/null
+"$top/bulk" -i 0 edited.txt output.txt check.txt $absolute \
+    > /dev/null 2>&1
+[ $? -eq 11 ] || fail "bulk refuses an input edited before its checkpoint"
+"$top/bulk" -i 0 input.txt output.txt check.txt $absolute \
+    2> resumed.txt > /dev/null &&
+    grep -q Resuming resumed.txt || fail "bulk resumes"
+"$top/bulk" corpus.txt whole.txt whole-check.txt \
+    $absolute > /dev/null 2>&1
+cmp -s output.txt whole.txt || fail "a resumed bulk run matches a whole one"
+cd "$top"
+
+# A search checkpoint and its leases belong to the files it was started on
+./generate -s 5 -c 400K "$work/search" 2> /dev/null
+head -c 300000 "$work/search/corpus.txt" > "$work/training.txt"
+plain=$(tail -c +300001 "$work/search/corpus.txt" | tr -cd A-Z | head -c 250)
+rotors="rotors/I.rot rotors/II.rot rotors/IV.rot"
+echo "$plain." | ciphertext plugboards/I.pb reflectors/I.rf rotors/II.rot \
+    rotors/I.rot rotors/IV.rot rotors/II.pos > "$work/ciphertext.txt"
+echo "Z" > "$work/other.txt"
+search="$work/training.txt $work/ciphertext.txt"
+search="$search plugboards/I.pb reflectors/I.rf"
+timeout 120 ./search coordinate "$work/socket" "$work/search.ck" $search \
+    $rotors > "$work/found.txt" 2> /dev/null &
+coordinator=$!
+for wait in $(seq 50); do
+    [ -S "$work/socket" ] && break
+    sleep 0.1
+done
+timeout 10 ./search work "$work/socket" ${search/ciphertext/other} $rotors \
+    2>&1 | grep -q "after 0 leases" || fail "a worker with other files works"
+timeout 120 ./search work "$work/socket" $search $rotors > /dev/null 2>&1
+wait $coordinator || fail "search coordinator"
+key="rotors/II.rot rotors/I.rot rotors/IV.rot  3 15 21 "
+head -1 "$work/found.txt" | grep -q "^$key" || fail "search finds the key"
+echo "X" >> "$work/ciphertext.txt"
+timeout 10 ./search coordinate "$work/socket" "$work/search.ck" $search \
+    $rotors > /dev/null 2>&1
+[ $? -eq 11 ] || fail "a search checkpoint for other files is refused"
+
+# Batch files match whether by io_uring, blocking calls, or a failed ring
+mkdir "$work/messages" "$work/ring" "$work/blocking" "$work/failed"
+for i in $(seq 300); do
+    tail -c +$((i * 997)) "$work/search/corpus.txt" | head -c $((i * 13)) \
+        > "$work/messages/m$i.txt"
+done
+ls "$work"/messages/*.txt | ./batch "$work/ring" $config > /dev/null 2>&1 ||
+    fail "batch"
+ls "$work"/messages/*.txt | ./batch -b "$work/blocking" $config > /dev/null \
+    2>&1 || fail "batch -b"
+diff -r -q "$work/ring" "$work/blocking" > /dev/null ||
+    fail "batch by io_uring matches blocking calls"
+ls "$work"/messages/*.txt | LD_PRELOAD=$top/tests/ring-fail.so \
+    ./batch "$work/failed" $config > /dev/null 2> "$work/failed.txt"
+[ $? -le 11 ] || fail "batch survives a failed ring"
+for file in "$work"/messages/*.txt; do
+    name=$(basename "$file")
+    grep -q "for '$file'" "$work/failed.txt" ||
+        cmp -s "$work/failed/$name" "$work/blocking/$name" ||
+        fail "$name is neither reported nor right after a failed ring"
+done
+
+# Serve replies in order, one line each, as the main program encrypts them
+printf 'HELLOWORLD\n\nABC1\nHELLOWORLDAGAIN\n' |
+    ./serve $config > "$work/served.txt" 2> /dev/null
+{
+    echo "$(echo 'HELLOWORLD.' | ciphertext $config)"
+    echo
+    echo "Error code 2."
+    echo "$(echo 'HELLOWORLDAGAIN.' | ciphertext $config)"
+} | cmp -s - "$work/served.txt" || fail "serve replies"
+
+# Trial rejects an empty top K, and a catalog cut short is refused
+./trial -k 0 "$work/training.txt" "$work/ciphertext.txt" $config \
+    > /dev/null 2>&1
+[ $? -eq 1 ] || fail "trial -k 0 is rejected"
+./catalog build "$work/catalog.bin" plugboards/I.pb reflectors/I.rf \
+    rotors/I.rot rotors/II.rot rotors/III.rot > /dev/null 2>&1 ||
+    fail "catalog build"
+head -c 1000 "$work/catalog.bin" > "$work/short.bin"
+./catalog query "$work/short.bin" "13,13/13,13/13,13" > /dev/null 2>&1
+[ $? -eq 11 ] || fail "a truncated catalog is refused"
+
+if [ $failures -gt 0 ]; then
+    echo "$failures regression checks failed." >&2
+    exit 1
+fi
+echo "All regression checks passed." >&2
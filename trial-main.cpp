@@ -0,0 +1,118 @@
+/* Trial decryption program
+ * 
+ * This file contains the main program for trial decryption over every rotor
+ * start position. Usage:
+ * './trial [-k <top k>] [-z <confidence>] <training text> <ciphertext>
+ *  <plugboard> <reflector> <rotorI> <rotorII>...<rotorx> <rotor pos>'
+ * Without '-z' a candidate is only abandoned once it provably cannot reach
+ * the top K; with it, the statistical bound in Scorer::bound is used.
+ * The best candidates are printed with their scores, followed by how much
+ * work early rejection saved. */
+
+#include "errors.h"
+#include "enigma.h"
+#include "enumerator.h"
+#include "fidelis.h"
+#include "scorer.h"
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+
+int main(int argc, char** argv)
+{
+    int err = NO_ERROR;
+    double confidence = 0;
+    int top_k = 10;
+
+    while (argc > 2 && (string(argv[1]) == "-z" || string(argv[1]) == "-k")) {
+        if (string(argv[1]) == "-z")
+            confidence = atof(argv[2]);
+        else
+            top_k = atoi(argv[2]);
+        argc -= 2;
+        argv += 2; // argv[2] takes the place of the program name
+    }
+
+    if (top_k < 1) {
+        cerr << "The top k must be at least 1.\n";
+        return INSUFFICIENT_NUMBER_OF_PARAMETERS;
+    }
+
+    if (argc < 5) {
+        cerr << "Too few command line parameters given.\n";
+        cerr << "'./trial [-k <top k>] [-z <confidence>] <training text> ";
+        cerr << "<ciphertext> ";
+        cerr << "<plugboard> <reflector> <rotorI> <rotorII>...<rotorx> ";
+        cerr << "<rotor pos>'\n\n";
+        return INSUFFICIENT_NUMBER_OF_PARAMETERS;
+    }
+
+    Scorer scorer;
+    ifstream training(argv[1]);
+    if ( (err = fileReadErr(argv[1], training)) )
+        return err;
+    scorer.train(training, err);
+    if (err) {
+        cerr << "Error code " << err << ". Exiting...\n";
+        return err;
+    }
+    scorer.setConfidence(confidence);
+
+    vector<int> text;
+    ifstream ct_file(argv[2]);
+    if ( (err = fileReadErr(argv[2], ct_file)) )
+        return err;
+    char ch;
+    ct_file >> ws >> ch;
+    while (ch != '.' && !ct_file.eof()) {
+        if (ch < 'A' || ch > 'Z') {
+            cerr << "\n'" << ch << "' is not a valid ciphertext character.\n";
+            return INVALID_INPUT_CHARACTER;
+        }
+        text.push_back(ch - 'A');
+        ct_file >> ws >> ch;
+    }
+
+    Enigma<> enigma(argc - 6);
+    enigma.setConfig(argc - 2, argv + 2, err);
+    // argv[2] takes the place of the program name
+    if (err) {
+        cerr << "Error code " << err << ". Exiting...\n";
+        return err;
+    }
+
+    KeyEnumerator keys(enigma);
+    TopK best(top_k);
+    TrialStats stats;
+    double score;
+
+    for (keys.seek(0); keys.key() < keys.size(); keys.next()) {
+        enigma.setPositions(keys.positions());
+        if (trialDecrypt(enigma, text.data(), text.size(), scorer,
+                         best.threshold(), score, stats))
+            best.offer(score, keys.key());
+    }
+
+    for (auto const& entry : best.results()) {
+        keys.seek(entry.second);
+        for (int i = 0; i < enigma.rotorCount(); i++)
+            cout << keys.positions()[i] << ' ';
+        cout << "score " << entry.first << '\n';
+    }
+
+    cerr << "\nCandidates: " << stats.candidates;
+    cerr << ", rejected early: " << stats.rejected << ".\n";
+    if (stats.rejected) {
+        cerr << "Letters decrypted per rejected candidate: ";
+        cerr << double(stats.rejected_letters) / stats.rejected;
+        cerr << " of " << text.size() << ".\n";
+    }
+    cerr << "Final threshold: " << best.threshold() << ".\n";
+
+    return NO_ERROR;
+}